@@ -0,0 +1,121 @@
+#include <map>
+#include <tuple>
+
+#include "collision_data.hpp"
+#include "pos_angle_setup.hpp"
+#include "search.hpp"
+
+// Checks that best-first search outputs setups in nondecreasing order of cost,
+// also after the frontier fills up and the search continues in cost bands, and
+// that the bands find every final state at the same lowest cost as a search
+// that never switches. Exits with status 1 on any difference.
+
+// Final position and angle of a setup
+typedef std::tuple<u32, u32, u32, u16> FinalState;
+
+struct BestFirstRun {
+  std::vector<int> costs;  // In output order
+  std::map<FinalState, int> lowestCosts;
+};
+
+BestFirstRun runBestFirst(const SearchParams& params) {
+  BestFirstRun run;
+  searchSetupsBestFirst(params, [&](Vec3f initialPos, u16 initialAngle,
+                                    const PosAngleSetup& setup,
+                                    const std::vector<Action>& path, int cost) {
+    run.costs.push_back(cost);
+    FinalState state = {floatToInt(setup.pos.x), floatToInt(setup.pos.y),
+                        floatToInt(setup.pos.z), setup.angle};
+    auto it = run.lowestCosts.find(state);
+    if (it == run.lowestCosts.end() || cost < it->second) {
+      run.lowestCosts[state] = cost;
+    }
+    return true;
+  });
+  return run;
+}
+
+// Returns false and prints the first setup output out of order.
+bool checkOrder(const char* name, const BestFirstRun& run) {
+  for (int i = 1; i < run.costs.size(); i++) {
+    if (run.costs[i] < run.costs[i - 1]) {
+      printf("%s: setup %d has cost %d after cost %d\n", name, i, run.costs[i],
+             run.costs[i - 1]);
+      return false;
+    }
+  }
+  printf("%s: %zu setups in order, costs %d-%d\n", name, run.costs.size(),
+         run.costs.empty() ? 0 : run.costs.front(),
+         run.costs.empty() ? 0 : run.costs.back());
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  // Small frontier limits that make the search switch to cost bands early
+  std::vector<int> frontiers = {1000, 100, 10};
+  if (argc > 1) {
+    frontiers = {atoi(argv[1])};
+  }
+
+  Collision col(&MIZUsin_sceneCollisionHeader_013C04, PLAYER_AGE_ADULT,
+                {-3060, 760, -280}, {-2820, 760, -80});
+  SearchParams params = {
+      .col = &col,
+      .minBounds = {-10000, 760, -10000},
+      .maxBounds = {10000, 10000, 10000},
+      .starts =
+          {
+              {{-2838, 760, -98}, 0x0000},
+              {{-2838, 760, -98}, 0x4000},
+          },
+      .maxCost = 40,
+      .angleMin = 0x0000,
+      .angleMax = 0x4000,
+      .xMin = -2950,
+      .xMax = -2850,
+      .zMin = -200,
+      .zMax = -100,
+      .actions =
+          {
+              ROLL,
+              BACKFLIP,
+              SIDEHOP_LEFT,
+              SIDEHOP_RIGHT,
+              ROTATE_ESS_LEFT,
+              ROTATE_ESS_RIGHT,
+              SHIELD_TURN_LEFT,
+              SHIELD_TURN_RIGHT,
+          },
+      .maxFrontier = std::numeric_limits<int>::max(),
+  };
+
+  BestFirstRun full = runBestFirst(params);
+  bool ok = checkOrder("unbounded frontier", full);
+
+  for (int maxFrontier : frontiers) {
+    params.maxFrontier = maxFrontier;
+    BestFirstRun banded = runBestFirst(params);
+    std::string name = "frontier " + std::to_string(maxFrontier);
+    ok &= checkOrder(name.c_str(), banded);
+
+    if (banded.lowestCosts != full.lowestCosts) {
+      printf("%s: found %zu final states, expected %zu\n", name.c_str(),
+             banded.lowestCosts.size(), full.lowestCosts.size());
+      for (const auto& [state, cost] : full.lowestCosts) {
+        auto it = banded.lowestCosts.find(state);
+        if (it == banded.lowestCosts.end() || it->second != cost) {
+          printf("  first difference: x=%08x y=%08x z=%08x angle=%04x cost=%d "
+                 "banded cost=%d\n",
+                 std::get<0>(state), std::get<1>(state), std::get<2>(state),
+                 std::get<3>(state), cost,
+                 it == banded.lowestCosts.end() ? -1 : it->second);
+          break;
+        }
+      }
+      ok = false;
+    }
+  }
+
+  printf(ok ? "ok\n" : "FAILED\n");
+  return ok ? 0 : 1;
+}
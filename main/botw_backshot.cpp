@@ -2,23 +2,34 @@
 #include "animation.hpp"
 #include "animation_data.hpp"
 #include "camera.hpp"
+#include "camera_angles.hpp"
 #include "collision.hpp"
 #include "collision_data.hpp"
 #include "global.hpp"
+#include "result_sink.hpp"
 #include "search.hpp"
 #include "sys_math.hpp"
 #include "sys_math3d.hpp"
 #include "sys_matrix.hpp"
 
+#include <cstring>
 #include <vector>
 
 u16 targetCameraAngles[0x10000];
 
-void initCameraAngles(Collision* col) {
-  for (int i = 0; i < 0x10000; i++) {
+// Simulates the camera for every angle, or loads the angles from
+// cameraAnglesPath (and saves them there the first time) if it isn't NULL.
+void initCameraAngles(Collision* col, const char* cameraAnglesPath) {
+  auto simulate = [=](u16 angle) {
     Camera camera(col);
-    camera.initParallel(Vec3f(0, 0, 0), i, 4);
-    targetCameraAngles[i] = camera.yaw();
+    camera.initParallel(Vec3f(0, 0, 0), angle, 4);
+    return camera.yaw();
+  };
+  if (cameraAnglesPath) {
+    loadCameraAngles(cameraAnglesPath, targetCameraAngles,
+                     hashCameraInputs(col, Vec3f(0, 0, 0), 4), simulate);
+  } else {
+    buildCameraAngles(targetCameraAngles, simulate);
   }
 }
 
@@ -533,6 +544,7 @@ void findSetups(Collision* col, int argc, char* argv[]) {
           },
   };
 
+  ResultSink sink;
   auto output = [&](Vec3f initialPos, u16 initialAngle,
                     const PosAngleSetup& setup, const std::vector<Action>& path,
                     int cost) {
@@ -560,25 +572,30 @@ void findSetups(Collision* col, int argc, char* argv[]) {
 
                   for (const auto& [yrotDiff, xrot, zrot] : weirdshotAims) {
                     if (testWeirdshot(weirdshotPos, angle + yrotDiff, xrot, zrot, weirdshotFrame, false)) {
-                      printf(
-                        "cost=%d startAngle=%04x startx=%.9g startz=%.9g angle=%04x "
-                        "startpos x=%.9g (%08x) z=%.9g (%08x) "
-                        "bombpos x=%.9g (%08x) z=%.9g (%08x) "
-                        "spacing x=%.9g (%08x) z=%.9g (%08x) actions=%s "
-                        "weirdshot x=%.9g (%08x) z=%.9g (%08x) frame=%d "
-                        "instant=%d controlStickDir=%04x rollBombTimer=%d unshieldFrame=%d untargetFrame=%d "
-                        "yrotdiff=%04x xrot=%04x zrot=%04x "
-                        "actions=%s\n",
-                        cost, initialAngle, initialPos.x, initialPos.z, angle,
-                        setup.pos.x, floatToInt(setup.pos.x), setup.pos.z, floatToInt(setup.pos.z),
-                        bombPos.x, floatToInt(bombPos.x), bombPos.z, floatToInt(bombPos.z),
-                        spacingSetup.pos.x, floatToInt(spacingSetup.pos.x), spacingSetup.pos.z, floatToInt(spacingSetup.pos.z),
-                        actionNames(spacingSetupActions).c_str(),
-                        weirdshotPos.x, floatToInt(weirdshotPos.x), weirdshotPos.z, floatToInt(weirdshotPos.z), weirdshotFrame,
-                        instant, controlStickDir, rollBombTimer, unshieldFrame, untargetFrame,
-                        yrotDiff, xrot, zrot,
-                        actionNames(path).c_str());
-                      fflush(stdout);
+                      sink.push(SearchResult(cost, initialPos, initialAngle, setup, path)
+                                    .customLayout()
+                                    .addHex("startAngle", initialAngle)
+                                    .addPlainFloat("startx", initialPos.x)
+                                    .addPlainFloat("startz", initialPos.z)
+                                    .addHex("angle", angle)
+                                    .addFloat("startpos x", setup.pos.x)
+                                    .addFloat("z", setup.pos.z)
+                                    .addFloat("bombpos x", bombPos.x)
+                                    .addFloat("z", bombPos.z)
+                                    .addFloat("spacing x", spacingSetup.pos.x)
+                                    .addFloat("z", spacingSetup.pos.z)
+                                    .addText("actions", actionNames(spacingSetupActions))
+                                    .addFloat("weirdshot x", weirdshotPos.x)
+                                    .addFloat("z", weirdshotPos.z)
+                                    .addInt("frame", weirdshotFrame)
+                                    .addInt("instant", instant)
+                                    .addHex("controlStickDir", controlStickDir)
+                                    .addInt("rollBombTimer", rollBombTimer)
+                                    .addInt("unshieldFrame", unshieldFrame)
+                                    .addInt("untargetFrame", untargetFrame)
+                                    .addHex("yrotdiff", yrotDiff)
+                                    .addHex("xrot", xrot)
+                                    .addHex("zrot", zrot));
                       found = true;
                     }
                   }
@@ -593,18 +610,25 @@ void findSetups(Collision* col, int argc, char* argv[]) {
     return found;
   };
 
-  if (argc > 1) {
-    int shard = atoi(argv[1]);
-    searchSetupsShard(params, 1, shard, output);
-  } else {
-    searchSetups(params, output);
-  }
+  searchSetupsMain(argc, argv, params, 1, output);
 }
 
 int main(int argc, char* argv[]) {
+  // --camera-angles FILE caches the camera angles in FILE. The other arguments
+  // are passed to searchSetupsMain.
+  const char* cameraAnglesPath = NULL;
+  std::vector<char*> args;
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--camera-angles") == 0 && i + 1 < argc) {
+      cameraAnglesPath = argv[++i];
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+
   Collision col(&HAKAdanCH_sceneCollisionHeader_00A558, PLAYER_AGE_ADULT, {-100, 240, 1300}, {100, 280, 1300});
 
-  initCameraAngles(&col);
+  initCameraAngles(&col, cameraAnglesPath);
 
   // searchWeirdshots();
   // validateWeirdshotStarts(&col, 0x8000, false);
@@ -614,7 +638,7 @@ int main(int argc, char* argv[]) {
   // startWeirdshot(&col, {intToFloat(0x41f385ba), 240.0f, intToFloat(0x44ae9d81)}, 0x8051, {intToFloat(0x421a268e), 240.0f, intToFloat(0x44a6d0a5)}, 0x8000, 2, 1, 1, &pos, &weirdshotFrame, true);
   // testWeirdshot(pos, 0x8051, 0x0, 0x4b0, weirdshotFrame, true);
 
-  findSetups(&col, argc, argv);
+  findSetups(&col, args.size(), args.data());
 
   return 0;
 }
@@ -3,6 +3,7 @@
 #include "animation_data.hpp"
 #include "collider.hpp"
 #include "collision_data.hpp"
+#include "result_sink.hpp"
 #include "search.hpp"
 #include "sys_math.hpp"
 #include "sys_math3d.hpp"
@@ -73,6 +74,7 @@ void findBomb1Setups(int argc, char* argv[]) {
           },
   };
 
+  ResultSink sink;
   auto output = [&](Vec3f initialPos, u16 initialAngle,
                     const PosAngleSetup& setup, const std::vector<Action>& path,
                     int cost) {
@@ -83,24 +85,15 @@ void findBomb1Setups(int argc, char* argv[]) {
       Vec3f bombPos = dropBomb(setup.pos, setup.angle, instant, swordInHand);
       if ((floatToInt(bombPos.z) & 0xFFFF) == 2) {
         found = true;
-        printf(
-            "cost=%d startAngle=%04x startx=%.9g startz=%.9g angle=%04x x=%.9g "
-            "(%08x) z=%.9g (%08x) instant=%d swordInHand=%d actions=%s\n",
-            cost, initialAngle, initialPos.x, initialPos.z, setup.angle,
-            setup.pos.x, floatToInt(setup.pos.x), setup.pos.z,
-            floatToInt(setup.pos.z), instant, swordInHand, actionNames(path).c_str());
-        fflush(stdout);
+        sink.push(SearchResult(cost, initialPos, initialAngle, setup, path)
+                      .addInt("instant", instant)
+                      .addInt("swordInHand", swordInHand));
       }
     }
     return found;
   };
 
-  if (argc > 1) {
-    int shard = atoi(argv[1]);
-    searchSetupsShard(params, 1, shard, output);
-  } else {
-    searchSetups(params, output);
-  }
+  searchSetupsMain(argc, argv, params, 1, output);
 }
 
 BgCamInfo gDTWebFloorColCamDataList[] = {
@@ -402,6 +395,7 @@ void findBomb2Setups(int argc, char* argv[]) {
           },
   };
 
+  ResultSink sink;
   auto output = [&](Vec3f initialPos, u16 initialAngle,
                     const PosAngleSetup& setup, const std::vector<Action>& path,
                     int cost) {
@@ -410,24 +404,14 @@ void findBomb2Setups(int argc, char* argv[]) {
     for (const BombDrop& bombDrop : bombDrops) {
       if ((s16)(setup.pos.x + bombDrop.deltax) == 0 && (s16)(setup.pos.z + bombDrop.deltaz) == 0) {
         found = true;
-        printf(
-            "cost=%d startAngle=%04x startx=%.9g startz=%.9g angle=%04x x=%.9g "
-            "(%08x) z=%.9g (%08x) bombTimer=%d actions=%s\n",
-            cost, initialAngle, initialPos.x, initialPos.z, setup.angle,
-            setup.pos.x, floatToInt(setup.pos.x), setup.pos.z,
-            floatToInt(setup.pos.z), bombDrop.bombTimer, actionNames(path).c_str());
-        fflush(stdout);
+        sink.push(SearchResult(cost, initialPos, initialAngle, setup, path)
+                      .addInt("bombTimer", bombDrop.bombTimer));
       }
     }
     return found;
   };
 
-  if (argc > 1) {
-    int shard = atoi(argv[1]);
-    searchSetupsShard(params, 1, shard, output);
-  } else {
-    searchSetups(params, output);
-  }
+  searchSetupsMain(argc, argv, params, 1, output);
 }
 
 int main(int argc, char* argv[]) {
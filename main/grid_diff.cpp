@@ -0,0 +1,266 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "asset_file.hpp"
+#include "collision_data.hpp"
+
+// Checks that the static poly grids don't change any collision results. For
+// each scene in collision_data.hpp, runs random queries near its vertices
+// through a Collision with the default grids and one with the grids disabled
+// (setGridCellSize(0)), which checks every poly in list order. Covers
+// runChecks, findFloor, entityLineTest and cameraLineTest, and the batched
+// runChecks, findFloors and cameraLineTests. Prints the first difference for
+// each scene and query, and exits with status 1 if there was any.
+//
+// With --assets FILE, the scenes are loaded from an asset file written by
+// pack_assets instead of the compiled-in headers, which also checks the grids
+// stored in the file.
+//
+// usage: grid_diff [--assets FILE] [QUERIES [SCENE]]
+
+struct GridDiff {
+  const char* name;
+  CollisionHeader* header;
+  bool ok = true;
+  bool reported = false;
+
+  // Starts a new query type, so that its first difference is reported
+  void start() { this->reported = false; }
+
+  int polyIndex(CollisionPoly* poly) const {
+    return poly ? poly - this->header->polys : -1;
+  }
+
+  bool samePos(Vec3f a, Vec3f b) const {
+    return floatToInt(a.x) == floatToInt(b.x) &&
+           floatToInt(a.y) == floatToInt(b.y) &&
+           floatToInt(a.z) == floatToInt(b.z);
+  }
+
+  // Reports a difference between the grid (a) and no-grid (b) results of the
+  // query at pos (and target)
+  void check(const char* query, int i, Vec3f pos, Vec3f target, Vec3f a,
+             Vec3f b, CollisionPoly* polyA, CollisionPoly* polyB) {
+    if (samePos(a, b) && polyA == polyB) {
+      return;
+    }
+    this->ok = false;
+    if (this->reported) {
+      return;
+    }
+    this->reported = true;
+    printf(
+        "%s: %s %d differs: pos=(%.9g, %.9g, %.9g) target=(%.9g, %.9g, "
+        "%.9g)\n"
+        "  grid:    (%.9g, %.9g, %.9g) poly=%d\n"
+        "  no grid: (%.9g, %.9g, %.9g) poly=%d\n",
+        this->name, query, i, pos.x, pos.y, pos.z, target.x, target.y,
+        target.z, a.x, a.y, a.z, polyIndex(polyA), b.x, b.y, b.z,
+        polyIndex(polyB));
+  }
+};
+
+// Returns false if any query on the scene differs
+bool diffScene(const char* name, std::shared_ptr<StaticCollision> staticCol,
+               int numQueries) {
+  CollisionHeader* header = staticCol->header;
+  if (header->numVertices == 0) {
+    return true;
+  }
+
+  Collision grid(staticCol, PLAYER_AGE_ADULT);
+  Collision noGrid(staticCol, PLAYER_AGE_ADULT);
+  noGrid.setGridCellSize(0);
+
+  // Random positions near the scene's vertices, and targets up to a few cells
+  // away
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<f32> nearby(-100, 100);
+  std::uniform_real_distribution<f32> far(-500, 500);
+  std::vector<Vec3f> positions(numQueries);
+  std::vector<Vec3f> targets(numQueries);
+  for (int i = 0; i < numQueries; i++) {
+    Vec3s v = header->vertices[rng() % header->numVertices];
+    f32 x = v.x + nearby(rng);
+    f32 y = v.y + nearby(rng);
+    f32 z = v.z + nearby(rng);
+    positions[i] = {x, y, z};
+    f32 dx = far(rng);
+    f32 dy = far(rng) / 4;
+    f32 dz = far(rng);
+    targets[i] = {x + dx, y + dy, z + dz};
+  }
+
+  GridDiff diff = {name, header};
+
+  // Short moves for runChecks
+  std::vector<CollisionCheck> checks(numQueries);
+  for (int i = 0; i < numQueries; i++) {
+    Vec3f pos = positions[i];
+    Vec3f target = targets[i];
+    checks[i] = {pos,
+                 {pos.x + (target.x - pos.x) / 20, pos.y,
+                  pos.z + (target.z - pos.z) / 20},
+                 26.0f,
+                 18.0f};
+  }
+
+  std::vector<CollisionCheckResult> expected(numQueries);
+  diff.start();
+  for (int i = 0; i < numQueries; i++) {
+    const CollisionCheck& c = checks[i];
+    CollisionCheckResult* e = &expected[i];
+    e->pos = noGrid.runChecks(c.prevPos, c.intendedPos, c.wallCheckHeight,
+                              c.wallCheckRadius, &e->wallPoly, &e->floorPoly,
+                              &e->dynaId, &e->floorHeight);
+
+    CollisionPoly* wallPoly;
+    CollisionPoly* floorPoly;
+    int dynaId;
+    f32 floorHeight;
+    Vec3f pos = grid.runChecks(c.prevPos, c.intendedPos, c.wallCheckHeight,
+                               c.wallCheckRadius, &wallPoly, &floorPoly,
+                               &dynaId, &floorHeight);
+    diff.check("runChecks (wall)", i, c.prevPos, c.intendedPos, pos, e->pos,
+               wallPoly, e->wallPoly);
+    diff.check("runChecks (floor)", i, c.prevPos, c.intendedPos,
+               {0, floorHeight, 0}, {0, e->floorHeight, 0}, floorPoly,
+               e->floorPoly);
+  }
+
+  std::vector<CollisionCheckResult> results(numQueries);
+  grid.runChecks(checks.data(), results.data(), numQueries);
+  diff.start();
+  for (int i = 0; i < numQueries; i++) {
+    const CollisionCheck& c = checks[i];
+    const CollisionCheckResult& r = results[i];
+    const CollisionCheckResult& e = expected[i];
+    diff.check("batched runChecks (wall)", i, c.prevPos, c.intendedPos, r.pos,
+               e.pos, r.wallPoly, e.wallPoly);
+    diff.check("batched runChecks (floor)", i, c.prevPos, c.intendedPos,
+               {0, r.floorHeight, 0}, {0, e.floorHeight, 0}, r.floorPoly,
+               e.floorPoly);
+  }
+
+  diff.start();
+  for (int i = 0; i < numQueries; i++) {
+    CollisionPoly* poly;
+    int dynaId;
+    expected[i].pos = noGrid.findFloor(positions[i], &expected[i].floorPoly,
+                                       &dynaId);
+    Vec3f pos = grid.findFloor(positions[i], &poly, &dynaId);
+    diff.check("findFloor", i, positions[i], positions[i], pos,
+               expected[i].pos, poly, expected[i].floorPoly);
+  }
+
+  grid.findFloors(positions.data(), results.data(), numQueries);
+  diff.start();
+  for (int i = 0; i < numQueries; i++) {
+    diff.check("batched findFloors", i, positions[i], positions[i],
+               results[i].pos, expected[i].pos, results[i].floorPoly,
+               expected[i].floorPoly);
+  }
+
+  diff.start();
+  for (int i = 0; i < numQueries; i++) {
+    // Every combination of poly lists
+    bool checkWalls = i & 1;
+    bool checkFloors = i & 2;
+    bool checkCeilings = i & 4;
+    CollisionPoly* polyA;
+    CollisionPoly* polyB;
+    Vec3f a = grid.entityLineTest(positions[i], targets[i], checkWalls,
+                                  checkFloors, checkCeilings, &polyA);
+    Vec3f b = noGrid.entityLineTest(positions[i], targets[i], checkWalls,
+                                    checkFloors, checkCeilings, &polyB);
+    diff.check("entityLineTest", i, positions[i], targets[i], a, b, polyA,
+               polyB);
+  }
+
+  std::vector<Vec3f> expectedLines(numQueries);
+  std::vector<CollisionPoly*> expectedPolys(numQueries);
+  diff.start();
+  for (int i = 0; i < numQueries; i++) {
+    expectedLines[i] =
+        noGrid.cameraLineTest(positions[i], targets[i], &expectedPolys[i]);
+    CollisionPoly* poly;
+    Vec3f pos = grid.cameraLineTest(positions[i], targets[i], &poly);
+    diff.check("cameraLineTest", i, positions[i], targets[i], pos,
+               expectedLines[i], poly, expectedPolys[i]);
+  }
+
+  std::vector<Vec3f> lines(numQueries);
+  std::vector<CollisionPoly*> polys(numQueries);
+  grid.cameraLineTests(positions.data(), targets.data(), lines.data(),
+                       polys.data(), numQueries);
+  diff.start();
+  for (int i = 0; i < numQueries; i++) {
+    diff.check("batched cameraLineTests", i, positions[i], targets[i],
+               lines[i], expectedLines[i], polys[i], expectedPolys[i]);
+  }
+
+  return diff.ok;
+}
+
+int main(int argc, char* argv[]) {
+  int numQueries = 20000;
+  const char* sceneName = NULL;
+  const char* assetsPath = NULL;
+  int numArgs = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--assets") == 0 && i + 1 < argc) {
+      assetsPath = argv[++i];
+    } else if (numArgs == 0) {
+      numQueries = atoi(argv[i]);
+      numArgs++;
+    } else if (numArgs == 1) {
+      sceneName = argv[i];
+      numArgs++;
+    } else {
+      fprintf(stderr, "usage: %s [--assets FILE] [QUERIES [SCENE]]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  AssetFile assets;
+  if (assetsPath && !assets.open(assetsPath)) {
+    return 1;
+  }
+
+  bool ok = true;
+  int numScenes = 0;
+  for (const SceneCollision& scene : sceneCollisions) {
+    if (sceneName && strcmp(scene.name, sceneName) != 0) {
+      continue;
+    }
+
+    // The same polys as the static scenes in pack_assets
+    std::shared_ptr<StaticCollision> staticCol;
+    if (assetsPath) {
+      staticCol = assets.staticCollision(std::string(scene.name) + "/static");
+      if (!staticCol) {
+        return 1;
+      }
+    } else {
+      staticCol = std::make_shared<StaticCollision>(
+          scene.header, Vec3f(-32768, -32768, -32768),
+          Vec3f(32767, 32767, 32767));
+    }
+    ok &= diffScene(scene.name, staticCol, numQueries);
+    numScenes++;
+  }
+  if (numScenes == 0) {
+    fprintf(stderr, "unknown scene %s\n", sceneName);
+    return 1;
+  }
+
+  printf("%d queries in %d scenes: %s\n", numQueries, numScenes,
+         ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -5,6 +5,7 @@
 #include "camera_angles.hpp"
 #include "collision_data.hpp"
 #include "collider.hpp"
+#include "result_sink.hpp"
 #include "search.hpp"
 #include "sys_math.hpp"
 #include "sys_matrix.hpp"
@@ -1188,7 +1189,8 @@ void findSetups(Collision* col, const HorseSetup& horseSetup) {
     return true;
   };
 
-    auto output = [=](Vec3f initialPos, u16 initialAngle,
+    ResultSink sink;
+    auto output = [=, &sink](Vec3f initialPos, u16 initialAngle,
                         const PosAngleSetup& setup,
                         const std::vector<Action>& actions, int cost) {
         bool found = false;
@@ -1199,15 +1201,21 @@ void findSetups(Collision* col, const HorseSetup& horseSetup) {
         int strainDir;
         bool nonCrit;
         if (testSetup(col, pos, angle, horseBody1, horseHeads, &jumpFrame, &neighFrame, &strainDir, &nonCrit, false)) {
-            printf(
-                "cost=%d horseX=%.9g (%08x) horseZ=%.9g (%08x) horseAngle=%04x "
-                "initialX=%.9g (%08x) initialZ=%.9g (%08x) initialAngle=%04x "
-                "x=%.9g (%08x) z=%.9g (%08x) angle=%04x jumpFrame=%d neighFrame=%d strainDir=%d nonCrit=%d actions=%s\n",
-                cost, horseSetup.horseX, floatToInt(horseSetup.horseX), horseSetup.horseZ, floatToInt(horseSetup.horseZ), horseAngle,
-                initialPos.x, floatToInt(initialPos.x), initialPos.z, floatToInt(initialPos.z), initialAngle,
-                pos.x, floatToInt(pos.x), pos.z, floatToInt(pos.z), angle, jumpFrame, neighFrame, strainDir, nonCrit,
-                actionNames(actions).c_str());
-            fflush(stdout);
+            sink.push(SearchResult(cost, initialPos, initialAngle, setup, actions)
+                          .customLayout()
+                          .addFloat("horseX", horseSetup.horseX)
+                          .addFloat("horseZ", horseSetup.horseZ)
+                          .addHex("horseAngle", horseAngle)
+                          .addFloat("initialX", initialPos.x)
+                          .addFloat("initialZ", initialPos.z)
+                          .addHex("initialAngle", initialAngle)
+                          .addFloat("x", pos.x)
+                          .addFloat("z", pos.z)
+                          .addHex("angle", angle)
+                          .addInt("jumpFrame", jumpFrame)
+                          .addInt("neighFrame", neighFrame)
+                          .addInt("strainDir", strainDir)
+                          .addInt("nonCrit", nonCrit));
             found = true;
         }
 
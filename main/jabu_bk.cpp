@@ -73,9 +73,42 @@ bool simulateHess(Collision* col, Vec3f pos, f32 speed, u16 startAngle,
   return false;
 }
 
+// Runs the camera consistency check for a batch of positions and tests the
+// ones that pass.
+void testHessPositions(Collision* col, u16 angle, f32 speed,
+                       const std::vector<Vec3f>& positions) {
+  u16 startAngle = angle - 7 * ESS;
+  int setting = 3;  // TODO: use floor?
+  u16 facingAngle = angle - (7 * 0x708) + 0x48;
+
+  // camera consistency check
+  std::vector<Camera> cameras(positions.size(), Camera(col));
+  std::vector<u16> angles(positions.size(), facingAngle);
+  for (size_t k = 0; k < positions.size(); k++) {
+    cameras[k].initParallel(positions[k], facingAngle, setting);
+  }
+  Camera::updateBatch(cameras.data(), positions.data(), angles.data(), setting,
+                      0, positions.size());
+
+  for (size_t k = 0; k < positions.size(); k++) {
+    Vec3f pos = positions[k];
+    if (cameras[k].wallPoly) {
+      continue;
+    }
+
+    if (simulateHess(col, pos, speed, startAngle, false)) {
+      printf(
+          "angle=%04x startAngle=%04x x=%.9g y=%.9g z=%.9g x_raw=%08x "
+          "y_raw=%08x z_raw=%08x\n",
+          angle, startAngle, pos.x, pos.y, pos.z, floatToInt(pos.x),
+          floatToInt(pos.y), floatToInt(pos.z));
+    }
+  }
+}
+
 void findHessPositions(Collision* col, u16 angle, f32 speed) {
   int i = 0;
-  u16 startAngle = angle - 7 * ESS;
+  std::vector<Vec3f> positions;
 
   for (f32 x = -80; x < 80; x += 2.0f) {
     for (f32 z = -2180; z < -1980; z += 0.005f) {
@@ -90,25 +123,14 @@ void findHessPositions(Collision* col, u16 angle, f32 speed) {
         continue;
       }
 
-      // camera consistency check
-      Camera camera(col);
-      int setting = 3;  // TODO: use floor?
-      u16 facingAngle = angle - (7 * 0x708) + 0x48;
-      camera.initParallel(pos, facingAngle, setting);
-      camera.updateNormal(pos, facingAngle, setting);
-      if (camera.wallPoly) {
-        continue;
-      }
-
-      if (simulateHess(col, pos, speed, startAngle, false)) {
-        printf(
-            "angle=%04x startAngle=%04x x=%.9g y=%.9g z=%.9g x_raw=%08x "
-            "y_raw=%08x z_raw=%08x\n",
-            angle, startAngle, pos.x, pos.y, pos.z, floatToInt(pos.x),
-            floatToInt(pos.y), floatToInt(pos.z));
+      positions.push_back(pos);
+      if (positions.size() == 1024) {
+        testHessPositions(col, angle, speed, positions);
+        positions.clear();
       }
     }
   }
+  testHessPositions(col, angle, speed, positions);
 }
 
 bool testClip(Collision* col, f32 x, f32 z, u16 angle, bool debug) {
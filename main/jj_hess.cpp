@@ -8,6 +8,7 @@
 #include "collision_data.hpp"
 #include "global.hpp"
 #include "pos_angle_setup.hpp"
+#include "progress.hpp"
 #include "sys_math.hpp"
 #include "sys_math3d.hpp"
 
@@ -603,9 +604,8 @@ std::vector<Action> addlActions = {
     SHIELD_TURN_RIGHT,
 };
 
-unsigned long long tested = 0;
-int close = 0;
-int found = 0;
+static ProgressReporter* reporter;
+static ProgressCounters* progress;
 
 void searchSetups(Vec3f initialPos, u16 initialAngle, std::vector<int>* targets,
                   std::vector<int>* essDirs, std::vector<HessResult>* results,
@@ -616,26 +616,24 @@ void searchSetups(Vec3f initialPos, u16 initialAngle, std::vector<int>* targets,
   u16 angle = setup.angle;
 
   if (depth == 0) {
-    if (tested % 10000 == 0) {
-      fprintf(stderr,
-              "tested=%llu close=%d found=%d k=%d x=%.0f z=%.0f angle=%04x "
-              "cost=%d ",
-              tested, close, found, k, initialPos.x, initialPos.z, initialAngle,
-              cost);
-      for (int i = 0; i < 3; i++) {
-        fprintf(stderr, "%s ", actionName((*actions)[i]));
-      }
-      fprintf(stderr, "... \r");
+    if (progress->ticked()) {
+      char status[256];
+      snprintf(status, sizeof(status),
+               "k=%d x=%.0f z=%.0f angle=%04x cost=%d %s %s %s", k,
+               initialPos.x, initialPos.z, initialAngle, cost,
+               actionName((*actions)[0]), actionName((*actions)[1]),
+               actionName((*actions)[2]));
+      reporter->setStatus(status);
     }
-    tested++;
+    progress->addTested();
 
     if (0xd6c0 <= angle && angle <= 0xe100 && pos.x < 75 && pos.z > -2900 &&
         pos.z < -2880) {
-      close++;
+      progress->addClose();
       results->clear();
       findHessPaths(setup.col, pos, angle, true, targets, essDirs, results);
       if (!results->empty()) {
-        found++;
+        progress->addFound();
 
         for (const auto& result : *results) {
           printf(
@@ -718,6 +716,10 @@ void findPosAngleSetups(Collision* col) {
       {{185, 467, -2972}, 0x4000},
   };
 
+  ProgressReporter searchReporter;
+  reporter = &searchReporter;
+  progress = searchReporter.addCounters();
+
   for (int depth = 9; depth <= 10; depth++) {
     for (const auto& initialPosition : initialPositions) {
       Vec3f initialPos = initialPosition.first;
@@ -727,6 +729,11 @@ void findPosAngleSetups(Collision* col) {
                    &actions, setup, 0, depth);
     }
   }
+  searchReporter.stop();
+
+  SearchStats stats = searchReporter.stats();
+  fprintf(stderr, "tested=%llu close=%llu found=%llu\n", stats.tested,
+          stats.close, stats.found);
 }
 
 int main(int argc, char* argv[]) {
@@ -4,6 +4,7 @@
 #include "collider.hpp"
 #include "collision_data.hpp"
 #include "pos_angle_setup.hpp"
+#include "result_sink.hpp"
 #include "search.hpp"
 #include "sys_math.hpp"
 
@@ -274,7 +275,8 @@ void findSetups(Collision* col) {
           },
   };
 
-  auto output = [=](Vec3f initialPos, u16 initialAngle,
+  ResultSink sink;
+  auto output = [=, &sink](Vec3f initialPos, u16 initialAngle,
                     const PosAngleSetup& setup,
                     const std::vector<Action>& actions, int cost) {
     bool found = false;
@@ -282,15 +284,15 @@ void findSetups(Collision* col) {
     u16 angle = setup.angle;
     for (bool holdUp : {false, true}) {
       if (testJumpslashClip(col, pos, angle, holdUp, false)) {
-        printf(
-            "cost=%d initialx=%.9g (%08x) initialz=%.9g (%08x) "
-            "initialAngle=%04x x=%.9g (%08x) z=%.9g (%08x) angle=%04x "
-            "holdUp=%d actions=%s\n",
-            cost, initialPos.x, floatToInt(initialPos.x), initialPos.z,
-            floatToInt(initialPos.z), initialAngle, pos.x, floatToInt(pos.x),
-            pos.z, floatToInt(pos.z), angle, holdUp,
-            actionNames(actions).c_str());
-        fflush(stdout);
+        sink.push(SearchResult(cost, initialPos, initialAngle, setup, actions)
+                      .customLayout()
+                      .addFloat("initialx", initialPos.x)
+                      .addFloat("initialz", initialPos.z)
+                      .addHex("initialAngle", initialAngle)
+                      .addFloat("x", pos.x)
+                      .addFloat("z", pos.z)
+                      .addHex("angle", angle)
+                      .addInt("holdUp", holdUp));
         found = true;
       }
     }
@@ -0,0 +1,141 @@
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "sys_math3d.hpp"
+
+// Checks that the sys_math3d routines give the same results when run on
+// several threads at once as on one thread, i.e. that they don't share
+// scratch state between calls. Runs a fixed set of random queries on one
+// thread, then on N threads at the same time, and exits with status 1 if any
+// result differs.
+
+// Hash of the results of one query of each routine
+typedef u64 QueryResult;
+
+std::vector<QueryResult> runQueries(int numQueries) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<f32> coord(-100, 100);
+  auto randomVec3f = [&]() {
+    f32 x = coord(rng);
+    f32 y = coord(rng);
+    f32 z = coord(rng);
+    return Vec3f(x, y, z);
+  };
+  auto randomVec3s = [&]() {
+    s16 x = rng() % 200 - 100;
+    s16 y = rng() % 200 - 100;
+    s16 z = rng() % 200 - 100;
+    return Vec3s(x, y, z);
+  };
+  auto randomCylinder = [&]() {
+    Cylinder16 cyl;
+    cyl.radius = rng() % 60;
+    cyl.height = rng() % 100;
+    cyl.yShift = (s16)(rng() % 50) - 25;
+    cyl.pos = randomVec3s();
+    return cyl;
+  };
+
+  std::vector<QueryResult> results;
+  results.reserve(numQueries);
+  for (int i = 0; i < numQueries; i++) {
+    QueryResult h = 0;
+    auto mix = [&](u32 value) { h = h * 1000003 ^ value; };
+
+    Vec3f va = randomVec3f();
+    Vec3f vb = randomVec3f();
+    Vec3f vc = randomVec3f();
+    Vec3f lineA = randomVec3f();
+    Vec3f lineB = randomVec3f();
+    TriNorm tri;
+    Math3D_TriNorm(&tri, &va, &vb, &vc);
+    Sphere16 sph;
+    sph.center = randomVec3s();
+    sph.radius = rng() % 60;
+    Cylinder16 cylA = randomCylinder();
+    Cylinder16 cylB = randomCylinder();
+
+    Vec3f intersect = {0, 0, 0};
+    mix(Math3D_TriVsSphIntersect(&sph, &tri, &intersect));
+    mix(floatToInt(intersect.x) ^ floatToInt(intersect.y) ^
+        floatToInt(intersect.z));
+
+    intersect = {0, 0, 0};
+    mix(Math3D_CylTriVsIntersect(&cylA, &tri, &intersect));
+    mix(floatToInt(intersect.x) ^ floatToInt(intersect.y) ^
+        floatToInt(intersect.z));
+
+    Vec3f intersectA = {0, 0, 0};
+    Vec3f intersectB = {0, 0, 0};
+    mix(Math3D_CylVsLineSeg(&cylA, &lineA, &lineB, &intersectA, &intersectB));
+    mix(floatToInt(intersectA.x) ^ floatToInt(intersectB.z));
+
+    Vec3f cubeMin = {-20, -20, -20};
+    Vec3f cubeMax = {20, 20, 20};
+    mix(Math3D_LineVsCube(&cubeMin, &cubeMax, &lineA, &lineB));
+
+    f32 overlap = 0;
+    f32 centerDist = 0;
+    mix(Math3D_SphVsCylOverlapCenterDist(&sph, &cylA, &overlap, &centerDist));
+    mix(floatToInt(overlap) ^ floatToInt(centerDist));
+    overlap = 0;
+    centerDist = 0;
+    mix(Math3D_CylVsCylOverlapCenterDist(&cylA, &cylB, &overlap,
+                                         &centerDist));
+    mix(floatToInt(overlap) ^ floatToInt(centerDist));
+
+    intersect = {0, 0, 0};
+    mix(Math3D_PlaneVsLineSegClosestPoint(
+        tri.plane.normal.x, tri.plane.normal.y, tri.plane.normal.z,
+        tri.plane.originDist, 0, 1, 0, -5, &lineA, &lineB, &intersect));
+    mix(floatToInt(intersect.x) ^ floatToInt(intersect.z));
+
+    f32 nx, ny, nz, originDist;
+    Math3D_DefPlane(&va, &vb, &vc, &nx, &ny, &nz, &originDist);
+    mix(floatToInt(nx) ^ floatToInt(ny) ^ floatToInt(nz) ^
+        floatToInt(originDist));
+
+    results.push_back(h);
+  }
+  return results;
+}
+
+int main(int argc, char* argv[]) {
+  int numThreads = 8;
+  int numQueries = 200000;
+  if (argc > 1) {
+    numThreads = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    numQueries = atoi(argv[2]);
+  }
+
+  std::vector<QueryResult> expected = runQueries(numQueries);
+
+  std::vector<std::vector<QueryResult>> threadResults(numThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; i++) {
+    threads.emplace_back(
+        [&, i]() { threadResults[i] = runQueries(numQueries); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  bool ok = true;
+  for (int i = 0; i < numThreads; i++) {
+    for (int j = 0; j < numQueries; j++) {
+      if (threadResults[i][j] != expected[j]) {
+        printf("thread %d: query %d differs from the single-thread result\n",
+               i, j);
+        ok = false;
+        break;
+      }
+    }
+  }
+
+  printf("%d queries on %d threads: %s\n", numQueries, numThreads,
+         ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "asset_file.hpp"
+#include "camera_angles.hpp"
+#include "collision_data.hpp"
+
+// Writes the scene collision and camera angle tables to an asset file. Each
+// scene is stored as a collision mesh NAME and a static scene NAME/static with
+// all of its polys.
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s OUTPUT\n", argv[0]);
+    return 1;
+  }
+
+  AssetWriter writer;
+  writer.addArray("cameraAngles", cameraAngles, ARRAY_COUNT(cameraAngles));
+  for (const SceneCollision& scene : sceneCollisions) {
+    StaticCollision col(scene.header, {-32768, -32768, -32768},
+                        {32767, 32767, 32767});
+    writer.addCollision(scene.name, scene.header);
+    if (!writer.addStaticCollision(std::string(scene.name) + "/static", &col)) {
+      return 1;
+    }
+  }
+  if (!writer.write(argv[1])) {
+    return 1;
+  }
+
+  // Check that everything loads
+  AssetFile file;
+  if (!file.open(argv[1])) {
+    return 1;
+  }
+  size_t count;
+  if (!file.array<u16>("cameraAngles", &count)) {
+    return 1;
+  }
+  for (const SceneCollision& scene : sceneCollisions) {
+    auto col = file.staticCollision(std::string(scene.name) + "/static");
+    if (!col) {
+      return 1;
+    }
+    printf("%s: %d polys (%d walls, %d floors, %d ceilings)\n", scene.name,
+           col->header->numPolys, (int)col->walls.size(),
+           (int)col->floors.size(), (int)col->ceilings.size());
+  }
+
+  return 0;
+}
@@ -6,6 +6,7 @@
 #include "collision_data.hpp"
 #include "global.hpp"
 #include "pos_angle_setup.hpp"
+#include "progress.hpp"
 #include "sys_math.hpp"
 
 Vec3f throwPosition(Vec3f pos, u16 angle) {
@@ -324,26 +325,27 @@ bool inOpenArea(Vec3f pos) {
 
 Vec3f rockPos = {-292, 0, -350};
 
-unsigned long long tested = 0;
-unsigned long long found = 0;
+static ProgressReporter* reporter;
+static ProgressCounters* progress;
 
 void testSetup(std::vector<Crumb>* path, int runningCost, Vec3f pos) {
-  if (tested % 10000 == 0) {
-    fprintf(stderr, "tested=%llu found=%llu depth=%lu ", tested, found,
-            path->size());
+  if (progress->ticked()) {
+    std::string status = "depth=" + std::to_string(path->size());
     for (int i = 0; i < std::min((int)path->size(), 5); i++) {
-      fprintf(stderr, "%s %04x, ", actionName((*path)[i].action),
-              (*path)[i].angle);
+      char crumb[64];
+      snprintf(crumb, sizeof(crumb), " %s %04x,", actionName((*path)[i].action),
+               (*path)[i].angle);
+      status += crumb;
     }
-    fprintf(stderr, "...\r");
+    reporter->setStatus(status);
   }
-  tested++;
+  progress->addTested();
 
   for (u16 walkAngle = 0xc010; walkAngle <= 0xc020; walkAngle += 0x10) {
     for (int taps = 1; taps <= 2; taps++) {
       if (simulateWalk(pos.x, pos.z + 4.5f * taps, walkAngle, walkAngle,
                        walkAngle, false)) {
-        found++;
+        progress->addFound();
 
         int cost = runningCost;
 
@@ -448,11 +450,19 @@ void searchSetups(Collision* col) {
   std::vector<SetupAction> actions = computeSetupActions();
   std::vector<Crumb> path;
 
+  ProgressReporter searchReporter;
+  reporter = &searchReporter;
+  progress = searchReporter.addCounters();
+
   for (int k = 8; k <= 10; k++) {
     path.reserve(k);
     doSearch(col, actions, 200, &path, 0,
              {intToFloat(0xc4084d4a), 1, intToFloat(0x433f0847)}, k);
   }
+  searchReporter.stop();
+
+  SearchStats stats = searchReporter.stats();
+  fprintf(stderr, "tested=%llu found=%llu\n", stats.tested, stats.found);
 }
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,36 @@
+#include <cstdio>
+#include <string>
+
+#include "result_sink.hpp"
+
+// Prints binary search results (from ResultSink::BINARY) in the text format.
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s FILE...\n", argv[0]);
+    return 1;
+  }
+
+  std::string buffer;
+  SearchResult result;
+  for (int i = 1; i < argc; i++) {
+    FILE* f = fopen(argv[i], "rb");
+    if (!f) {
+      fprintf(stderr, "could not open %s\n", argv[i]);
+      return 1;
+    }
+    if (!readResultHeader(f)) {
+      fprintf(stderr, "%s is not a search results file\n", argv[i]);
+      fclose(f);
+      return 1;
+    }
+
+    while (readResult(f, &result)) {
+      buffer.clear();
+      formatResult(result, &buffer);
+      fwrite(buffer.data(), 1, buffer.size(), stdout);
+    }
+    fclose(f);
+  }
+
+  return 0;
+}
@@ -165,21 +165,63 @@ bool testLedgeClip(Collision* col, Vec3f pos, u16 angle, f32 speed,
   return true;
 }
 
-void findSidehopLedgeClips(Collision* col) {
+// Walks every z in a row at once with the batched runChecks. If checkBatch is
+// set, also walks each position with the scalar runChecks and exits if the
+// results differ.
+void findSidehopLedgeClips(Collision* col, bool checkBatch) {
   int tested = 0;
   int found = 0;
+  f32 wallCheckRadius = col->age == PLAYER_AGE_CHILD ? 14.0f : 18.0f;
+  std::vector<Vec3f> startPositions;
+  std::vector<CollisionCheck> checks;
+  std::vector<CollisionCheckResult> results;
   for (u16 angle = 0x5000; angle <= 0x8000; angle += 0x10) {
     for (f32 x = 2850; x <= 2920; x += 1.0f) {
+      startPositions.clear();
       for (f32 z = -290; z <= -200; z += 1.0f) {
+        startPositions.push_back({x, -10, z});
+      }
+      int count = startPositions.size();
+      checks.resize(count);
+      results.resize(count);
+      for (int j = 0; j < count; j++) {
+        results[j].pos = startPositions[j];
+      }
+      for (int i = 0; i < 6; i++) {
+        for (int j = 0; j < count; j++) {
+          Vec3f pos = results[j].pos;
+          checks[j] = {pos, translate(pos, angle + 0x4000, 8.5f, 0.0f), 26.0f,
+                       wallCheckRadius};
+        }
+        col->runChecks(checks.data(), results.data(), count);
+      }
+
+      for (int j = 0; j < count; j++) {
+        f32 z = startPositions[j].z;
         if (tested % 100000 == 0) {
           fprintf(stderr, "tested=%d found=%d angle=%04x x=%.2f z=%.2f ...\r",
                   tested, found, angle, x, z);
         }
         tested++;
 
-        Vec3f pos = {x, -10, z};
-        for (int i = 0; i < 6; i++) {
-          pos = col->runChecks(pos, translate(pos, angle + 0x4000, 8.5f, 0.0f));
+        Vec3f pos = results[j].pos;
+        if (checkBatch) {
+          Vec3f expected = startPositions[j];
+          for (int i = 0; i < 6; i++) {
+            expected = col->runChecks(
+                expected, translate(expected, angle + 0x4000, 8.5f, 0.0f));
+          }
+          if (floatToInt(pos.x) != floatToInt(expected.x) ||
+              floatToInt(pos.y) != floatToInt(expected.y) ||
+              floatToInt(pos.z) != floatToInt(expected.z)) {
+            fprintf(stderr,
+                    "batched runChecks differs: angle=%04x x=%.9g z=%.9g "
+                    "batched=(%08x, %08x, %08x) scalar=(%08x, %08x, %08x)\n",
+                    angle, x, z, floatToInt(pos.x), floatToInt(pos.y),
+                    floatToInt(pos.z), floatToInt(expected.x),
+                    floatToInt(expected.y), floatToInt(expected.z));
+            exit(1);
+          }
         }
 
         Vec3f outPos;
@@ -220,9 +262,9 @@ std::vector<Action> addlActions = {
     SHIELD_TURN_RIGHT,
 };
 
-unsigned long long tested = 0;
-int close = 0;
-int found = 0;
+static unsigned long long tested = 0;
+static int numClose = 0;
+static int found = 0;
 int maxCost = 66;
 
 bool inRange(Vec3f pos, u16 angle) {
@@ -302,7 +344,7 @@ void search(Collision* corridorCol, const PosAngleSetup& setup,
 
   tested++;
   if (inRange(setup.pos, setup.angle)) {
-    close++;
+    numClose++;
     if (testMegaflip(corridorCol, setup.col, setup.pos, setup.angle, false)) {
       found++;
 
@@ -412,7 +454,7 @@ int main(int argc, char* argv[]) {
   // testLedgeClip(&ledgeCol, {2833.5f, -10, -262}, 0x8000, 7.5f, 0xc000, true,
   //               &outPos);
 
-  // findSidehopLedgeClips(&ledgeCol);
+  // findSidehopLedgeClips(&ledgeCol, false);
   findSetups(&corridorCol, &platformCol);
 
   return 0;
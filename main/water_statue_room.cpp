@@ -3,6 +3,7 @@
 #include "collider.hpp"
 #include "collision_data.hpp"
 #include "pos_angle_setup.hpp"
+#include "result_sink.hpp"
 #include "search.hpp"
 #include "sys_math.hpp"
 
@@ -100,6 +101,8 @@ void findTwistedMegaLandings() {
   }
 }
 
+bool testMegaflipLanding(Vec3f pos, u16 angle, u16 movementAngle, bool debug);
+
 bool testMegaflip(Vec3f pos, u16 angle, bool debug) {
   u16 facingAngle = angle;
   u16 movementAngle = cameraAngles[angle] + 0x8000;
@@ -122,6 +125,58 @@ bool testMegaflip(Vec3f pos, u16 angle, bool debug) {
     }
   }
 
+  return testMegaflipLanding(pos, angle, movementAngle, debug);
+}
+
+// testMegaflip for a batch of positions at the same angle. Until the jump,
+// every position moves by the same amounts, so this part runs on all of them
+// at once (and can be vectorized). Returns a mask of the positions that work.
+u32 testMegaflipBatch(u16 angle, const PosBatch& batch) {
+  u16 facingAngle = angle;
+  u16 movementAngle = cameraAngles[angle] + 0x8000;
+
+  f32 x[PosBatch::SIZE];
+  f32 z[PosBatch::SIZE];
+  bool alive[PosBatch::SIZE];
+  for (int j = 0; j < PosBatch::SIZE; j++) {
+    x[j] = batch.x[j];
+    z[j] = batch.z[j];
+    alive[j] = j < batch.count;
+  }
+
+  // Same arithmetic as translate(), which adds the velocity times 1.5
+  auto step = [&](f32 xzSpeed) {
+    f32 dx = Math_SinS(movementAngle) * xzSpeed * 1.5f;
+    f32 dz = Math_CosS(movementAngle) * xzSpeed * 1.5f;
+    for (int j = 0; j < PosBatch::SIZE; j++) {
+      x[j] = x[j] + dx;
+      z[j] = z[j] + dz;
+    }
+  };
+
+  step(1.5f);
+  step(1.5f);
+  for (int i = 0; i < 11; i++) {
+    Math_ScaledStepToS(&movementAngle, facingAngle, 2000);
+    Math_ScaledStepToS(&facingAngle, movementAngle, 2000);
+    step(3.0f);
+    for (int j = 0; j < PosBatch::SIZE; j++) {
+      alive[j] = alive[j] && !(z[j] < -281);
+    }
+  }
+
+  u32 found = 0;
+  for (int j = 0; j < batch.count; j++) {
+    if (alive[j] && testMegaflipLanding({x[j], 760, z[j]}, angle,
+                                        movementAngle, false)) {
+      found |= 1u << j;
+    }
+  }
+  return found;
+}
+
+// The rest of testMegaflip from the start of the jump.
+bool testMegaflipLanding(Vec3f pos, u16 angle, u16 movementAngle, bool debug) {
   movementAngle -= 2 * 0xbb8;
   f32 ySpeed = 4.8f;
   pos = translate(pos, movementAngle, -6.0f, 5.8f);
@@ -164,29 +219,32 @@ bool testMegaflip(Vec3f pos, u16 angle, bool debug) {
 }
 
 void findMegaflips() {
-  unsigned long long tested = 0;
-  int found = 0;
-  for (u16 angle = 0x0000; angle <= 0x1000; angle += 0x8) {
-    for (f32 x = -3061; x < -3000; x += 0.1f) {
-      for (f32 z = -281; z < -190; z += 0.1f) {
-        if (tested % 1000000 == 0) {
-          fprintf(stderr,
-                  "tested=%llu found=%d angle=%04x x=%.2f z=%.2f ... \r",
-                  tested, found, angle, x, z);
-        }
-        tested++;
+  PosAngleRange range = {
+      .angleMin = 0x0000,
+      .angleMax = 0x1000,
+      .angleStep = 0x8,
+      .xMin = -3061.0f,
+      .xMax = -3000.0f,
+      .xStep = 0.1f,
+      .zMin = -281.0f,
+      .zMax = -190.0f,
+      .zStep = 0.1f,
+      .numThreads = 0,
+  };
 
-        Vec3f pos = {x, 760, z};
-        if (testMegaflip(pos, angle, false)) {
-          found++;
-          printf(
-              "angle=%04x x=%.9g x_raw=%08x z=%.9g "
-              "z_raw=%08x\n",
-              angle, pos.x, floatToInt(pos.x), pos.z, floatToInt(pos.z));
-        }
+  searchPosAngleRangeBatched(range, [](u16 angle, const PosBatch& batch) {
+    u32 found = testMegaflipBatch(angle, batch);
+    for (int j = 0; j < batch.count; j++) {
+      if (found & (1u << j)) {
+        printf(
+            "angle=%04x x=%.9g x_raw=%08x z=%.9g "
+            "z_raw=%08x\n",
+            angle, batch.x[j], floatToInt(batch.x[j]), batch.z[j],
+            floatToInt(batch.z[j]));
       }
     }
-  }
+    return found;
+  });
 }
 
 void findPosAngleSetups(Collision* col, int argc, char* argv[]) {
@@ -239,28 +297,18 @@ void findPosAngleSetups(Collision* col, int argc, char* argv[]) {
           },
   };
 
+  ResultSink sink;
   auto output = [&](Vec3f initialPos, u16 initialAngle,
                     const PosAngleSetup& setup, const std::vector<Action>& path,
                     int cost) {
     if (testMegaflip(setup.pos, setup.angle, false)) {
-      printf(
-          "cost=%d startAngle=%04x startx=%.9g startz=%.9g angle=%04x x=%.9g "
-          "(%08x) z=%.9g (%08x) actions=%s\n",
-          cost, initialAngle, initialPos.x, initialPos.z, setup.angle,
-          setup.pos.x, floatToInt(setup.pos.x), setup.pos.z,
-          floatToInt(setup.pos.z), actionNames(path).c_str());
-      fflush(stdout);
+      sink.push(SearchResult(cost, initialPos, initialAngle, setup, path));
       return true;
     }
     return false;
   };
 
-  if (argc > 1) {
-    int shard = atoi(argv[1]);
-    searchSetupsShard(params, 1, shard, output);
-  } else {
-    searchSetups(params, output);
-  }
+  searchSetupsMain(argc, argv, params, 1, output);
 }
 
 int main(int argc, char* argv[]) {
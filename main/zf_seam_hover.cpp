@@ -3,6 +3,7 @@
 #include "animation_data.hpp"
 #include "collider.hpp"
 #include "collision_data.hpp"
+#include "result_sink.hpp"
 #include "search.hpp"
 #include "sys_math.hpp"
 #include "sys_math3d.hpp"
@@ -10,9 +11,18 @@
 void printSeamHeights(Collision* col) {
   f32 cx = -1822;
   f32 cz = 1923;
+  std::vector<Vec3f> row;
+  std::vector<CollisionCheckResult> results;
   for (f32 x = cx - 1.0f; x <= cx + 1.0f; x += 0.01f) {
+    row.clear();
     for (f32 z = cz - 1.0f; z <= cz + 1.0f; z += 0.01f) {
-      Vec3f pos = col->findFloor({x, 1000, z});
+      row.push_back({x, 1000, z});
+    }
+    results.resize(row.size());
+    col->findFloors(row.data(), results.data(), row.size());
+
+    for (const CollisionCheckResult& result : results) {
+      Vec3f pos = result.pos;
       if (pos.y >= 95.3f) {
         printf("x=%.9g y=%.9g z=%.9g x_raw=%08x y_raw=%08x z_raw=%08x\n", pos.x,
                pos.y, pos.z, floatToInt(pos.x), floatToInt(pos.y),
@@ -174,6 +184,7 @@ void findSetups(Collision* col, int argc, char* argv[]) {
     return true;
   };
 
+  ResultSink sink;
   auto output = [&](Vec3f initialPos, u16 initialAngle,
                     const PosAngleSetup& setup, const std::vector<Action>& path,
                     int cost) {
@@ -202,24 +213,14 @@ void findSetups(Collision* col, int argc, char* argv[]) {
 
     f32 finalHeight;
     if (testJumpToSeam(col, setup.pos, angle, xzSpeed, ySpeed, &finalHeight)) {
-      printf(
-          "cost=%d startAngle=%04x startx=%.9g startz=%.9g angle=%04x x=%.9g "
-          "(%08x) z=%.9g (%08x) finalHeight=%.9g actions=%s\n",
-          cost, initialAngle, initialPos.x, initialPos.z, setup.angle,
-          setup.pos.x, floatToInt(setup.pos.x), setup.pos.z,
-          floatToInt(setup.pos.z), finalHeight, actionNames(path).c_str());
-      fflush(stdout);
+      sink.push(SearchResult(cost, initialPos, initialAngle, setup, path)
+                    .addPlainFloat("finalHeight", finalHeight));
       return true;
     }
     return false;
   };
 
-  if (argc > 1) {
-    int shard = atoi(argv[1]);
-    searchSetupsShard(params, 1, shard, filter, output);
-  } else {
-    searchSetups(params, filter, output);
-  }
+  searchSetupsMain(argc, argv, params, 1, filter, output);
 }
 
 // Experimentally-determined skulltula hitbox positions
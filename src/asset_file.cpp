@@ -0,0 +1,607 @@
+#include "asset_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+static const char ASSET_MAGIC[8] = {'O', 'O', 'T', 'A', 'S', 'S', 'E', 'T'};
+
+struct AssetFileHeader {
+  char magic[8];
+  u32 version;
+  u32 numSections;
+};
+
+struct AssetSectionEntry {
+  char name[40];  // Null-terminated
+  u32 type;
+  u32 pad;
+  u64 offset;
+  u64 size;
+};
+
+// Start of a collision section. Offsets are from the start of the section.
+struct AssetCollision {
+  Vec3s minBound;
+  Vec3s maxBound;
+  u32 numVertices;
+  u32 numPolys;
+  u32 numSurfaceTypes;
+  u32 numBgCams;
+  u32 numWaterBoxes;
+  u32 verticesOffset;
+  u32 polysOffset;
+  u32 surfaceTypesOffset;
+  u32 bgCamsOffset;
+  u32 waterBoxesOffset;
+};
+
+struct AssetBgCam {
+  u16 setting;
+  s16 count;
+};
+
+// Appends values to a section. Arrays are aligned so that they can be used in
+// place once the file is mapped.
+struct AssetBuilder {
+  std::string* out;
+
+  void align(size_t alignment) {
+    out->resize((out->size() + alignment - 1) / alignment * alignment, '\0');
+  }
+
+  template <typename T>
+  size_t put(const T& value) {
+    size_t offset = out->size();
+    out->append((const char*)&value, sizeof(T));
+    return offset;
+  }
+
+  template <typename T>
+  size_t putArray(const T* data, size_t count) {
+    align(8);
+    size_t offset = out->size();
+    out->append((const char*)data, count * sizeof(T));
+    return offset;
+  }
+
+  // Writes the length first, for arrays that are read back by AssetReader
+  template <typename T>
+  void putVector(const std::vector<T>& v) {
+    align(8);
+    put<u64>(v.size());
+    putArray(v.data(), v.size());
+  }
+};
+
+// Reads values written by AssetBuilder::put and putVector, failing instead of
+// reading past the end of the section.
+struct AssetReader {
+  const u8* begin;
+  const u8* end;
+  size_t pos = 0;
+  bool ok = true;
+
+  bool need(size_t size) {
+    if (!this->ok || size > (size_t)(this->end - this->begin) - this->pos) {
+      this->ok = false;
+    }
+    return this->ok;
+  }
+
+  void align(size_t alignment) {
+    size_t next = (this->pos + alignment - 1) / alignment * alignment;
+    if (need(next - this->pos)) {
+      this->pos = next;
+    }
+  }
+
+  template <typename T>
+  T get() {
+    T value{};
+    if (need(sizeof(T))) {
+      memcpy(&value, this->begin + this->pos, sizeof(T));
+      this->pos += sizeof(T);
+    }
+    return value;
+  }
+
+  template <typename T>
+  void getVector(std::vector<T>* v) {
+    align(8);
+    u64 count = get<u64>();
+    align(8);
+    if (count > (size_t)(this->end - this->begin) / sizeof(T) ||
+        !need(count * sizeof(T))) {
+      this->ok = false;
+      v->clear();
+      return;
+    }
+    v->resize(count);
+    memcpy((void*)v->data(), this->begin + this->pos, count * sizeof(T));
+    this->pos += count * sizeof(T);
+  }
+};
+
+// Calls f with each array of a StaticPolyCache, in file order.
+template <typename C, typename F>
+static void StaticPolyCache_ForEachArray(C* cache, F f) {
+  f(cache->xMin);
+  f(cache->xMax);
+  f(cache->yMin);
+  f(cache->yMax);
+  f(cache->zMin);
+  f(cache->zMax);
+  f(cache->lineMinY);
+  f(cache->nx);
+  f(cache->ny);
+  f(cache->nz);
+  f(cache->rawNx);
+  f(cache->rawNy);
+  f(cache->rawNz);
+  f(cache->dist);
+  f(cache->normMagnitude);
+  f(cache->invNormalXZ);
+  f(cache->xDist);
+  f(cache->zDist);
+  f(cache->verts);
+  f(cache->raycastYMin);
+  f(cache->raycastYMax);
+}
+
+// Returns whether every array of the cache has an entry for each of numPolys
+// polys (three for verts)
+static bool StaticPolyCache_HasPolys(const StaticPolyCache* cache,
+                                     size_t numPolys) {
+  bool ok = true;
+  StaticPolyCache_ForEachArray(cache, [&](const auto& v) {
+    size_t perPoly =
+        std::is_same_v<typename std::decay_t<decltype(v)>::value_type, Vec3f>
+            ? 3
+            : 1;
+    ok &= v.size() == numPolys * perPoly;
+  });
+  return ok;
+}
+
+// Grid cells are stored as one array of poly indices (or camera grid keys) and
+// the offset of each cell in it.
+static void StaticGrid_PutCells(AssetBuilder* b,
+                                const std::vector<std::vector<int>>& cells) {
+  std::vector<u32> offsets;
+  std::vector<s32> indices;
+  for (const std::vector<int>& cell : cells) {
+    offsets.push_back(indices.size());
+    indices.insert(indices.end(), cell.begin(), cell.end());
+  }
+  offsets.push_back(indices.size());
+  b->putVector(offsets);
+  b->putVector(indices);
+}
+
+// valid(index) returns whether an index refers to a poly in the scene
+template <typename V>
+static void StaticGrid_GetCells(AssetReader* r, V valid,
+                                std::vector<std::vector<int>>* cells) {
+  std::vector<u32> offsets;
+  std::vector<s32> indices;
+  r->getVector(&offsets);
+  r->getVector(&indices);
+  cells->clear();
+  if (offsets.empty()) {
+    r->ok = false;
+    return;
+  }
+  for (s32 index : indices) {
+    if (!valid(index)) {
+      r->ok = false;
+      return;
+    }
+  }
+  for (size_t i = 0; i + 1 < offsets.size(); i++) {
+    if (offsets[i] > offsets[i + 1] || offsets[i + 1] > indices.size()) {
+      r->ok = false;
+      return;
+    }
+    cells->emplace_back(indices.begin() + offsets[i],
+                        indices.begin() + offsets[i + 1]);
+  }
+}
+
+static void StaticGrid_Put(AssetBuilder* b, const StaticGrid* grid) {
+  b->put(grid->xMin);
+  b->put(grid->zMin);
+  b->put(grid->cellSize);
+  b->put<s32>(grid->numX);
+  b->put<s32>(grid->numZ);
+  StaticGrid_PutCells(b, grid->cells);
+  StaticGrid_PutCells(b, grid->cellsByY);
+}
+
+template <typename V>
+static void StaticGrid_Get(AssetReader* r, V valid, StaticGrid* grid) {
+  grid->xMin = r->get<f32>();
+  grid->zMin = r->get<f32>();
+  grid->cellSize = r->get<f32>();
+  grid->numX = r->get<s32>();
+  grid->numZ = r->get<s32>();
+  StaticGrid_GetCells(r, valid, &grid->cells);
+  StaticGrid_GetCells(r, valid, &grid->cellsByY);
+  size_t numCells = (size_t)grid->numX * grid->numZ;
+  // An enabled grid needs at least one cell, and a disabled one has none
+  bool enabled = grid->cellSize > 0.0f;
+  if (!std::isfinite(grid->cellSize) || grid->cellSize < 0.0f ||
+      grid->numX < 0 || grid->numZ < 0 || (numCells > 0) != enabled ||
+      grid->cells.size() != numCells ||
+      (!grid->cellsByY.empty() && grid->cellsByY.size() != numCells)) {
+    r->ok = false;
+  }
+}
+
+void AssetWriter::addData(const std::string& name, const void* data,
+                          size_t size) {
+  this->sections.push_back(
+      {name, ASSET_DATA, std::string((const char*)data, size)});
+}
+
+void AssetWriter::addCollision(const std::string& name,
+                               const CollisionHeader* header) {
+  // Headers don't store the length of these lists, so count the entries that
+  // the polys refer to
+  u32 numSurfaceTypes = 0;
+  for (int i = 0; i < header->numPolys; i++) {
+    numSurfaceTypes = std::max<u32>(numSurfaceTypes, header->polys[i].type + 1);
+  }
+  u32 numBgCams = 0;
+  if (header->bgCamList) {
+    for (u32 i = 0; i < numSurfaceTypes; i++) {
+      u32 bgCamIndex = header->surfaceTypeList[i].data[0] & 0xFF;
+      numBgCams = std::max(numBgCams, bgCamIndex + 1);
+    }
+  }
+
+  std::string data;
+  AssetBuilder b = {&data};
+  AssetCollision col = {};
+  b.put(col);
+  col.minBound = header->minBound;
+  col.maxBound = header->maxBound;
+  col.numVertices = header->numVertices;
+  col.numPolys = header->numPolys;
+  col.numSurfaceTypes = numSurfaceTypes;
+  col.numBgCams = numBgCams;
+  col.numWaterBoxes = header->numWaterBoxes;
+  col.verticesOffset = b.putArray(header->vertices, header->numVertices);
+  col.polysOffset = b.putArray(header->polys, header->numPolys);
+  col.surfaceTypesOffset =
+      b.putArray(header->surfaceTypeList, numSurfaceTypes);
+  std::vector<AssetBgCam> bgCams;
+  for (u32 i = 0; i < numBgCams; i++) {
+    bgCams.push_back(
+        {header->bgCamList[i].setting, header->bgCamList[i].count});
+  }
+  col.bgCamsOffset = b.putArray(bgCams.data(), bgCams.size());
+  col.waterBoxesOffset =
+      b.putArray(header->waterBoxes, header->numWaterBoxes);
+  memcpy(data.data(), &col, sizeof(col));
+
+  this->sections.push_back({name, ASSET_COLLISION, std::move(data)});
+  this->collisions.push_back({header, name});
+}
+
+bool AssetWriter::addStaticCollision(const std::string& name,
+                                     const StaticCollision* scene) {
+  const std::string* collisionName = NULL;
+  for (const auto& [header, headerName] : this->collisions) {
+    if (header == scene->header) {
+      collisionName = &headerName;
+    }
+  }
+  if (!collisionName) {
+    fprintf(stderr, "static collision %s: collision header was not added\n",
+            name.c_str());
+    return false;
+  }
+
+  std::string data;
+  AssetBuilder b = {&data};
+  b.putVector(std::vector<char>(collisionName->begin(), collisionName->end()));
+
+  auto putPolys = [&](const std::vector<CollisionPoly*>& polys) {
+    std::vector<s32> indices;
+    for (CollisionPoly* poly : polys) {
+      indices.push_back(poly - scene->polyList);
+    }
+    b.putVector(indices);
+  };
+  putPolys(scene->walls);
+  putPolys(scene->floors);
+  putPolys(scene->ceilings);
+
+  for (const StaticPolyCache* cache :
+       {&scene->wallCache, &scene->floorCache, &scene->ceilingCache}) {
+    StaticPolyCache_ForEachArray(cache, [&](const auto& v) { b.putVector(v); });
+  }
+  for (const StaticGrid* grid : {&scene->wallGrid, &scene->floorGrid,
+                                 &scene->ceilingGrid, &scene->cameraGrid}) {
+    StaticGrid_Put(&b, grid);
+  }
+
+  this->sections.push_back({name, ASSET_STATIC_COLLISION, std::move(data)});
+  return true;
+}
+
+bool AssetWriter::write(const std::string& path) const {
+  AssetFileHeader header;
+  memcpy(header.magic, ASSET_MAGIC, sizeof(header.magic));
+  header.version = ASSET_FILE_VERSION;
+  header.numSections = this->sections.size();
+
+  std::vector<AssetSectionEntry> entries;
+  u64 offset =
+      sizeof(header) + this->sections.size() * sizeof(AssetSectionEntry);
+  for (const Section& section : this->sections) {
+    AssetSectionEntry entry = {};
+    if (section.name.size() >= sizeof(entry.name)) {
+      fprintf(stderr, "asset name too long: %s\n", section.name.c_str());
+      return false;
+    }
+    memcpy(entry.name, section.name.data(), section.name.size());
+    entry.type = section.type;
+    offset = (offset + 15) / 16 * 16;
+    entry.offset = offset;
+    entry.size = section.data.size();
+    offset += entry.size;
+    entries.push_back(entry);
+  }
+
+  // Write to a temporary file first so that programs never map a partial file
+  std::string tmpPath = path + ".tmp";
+  FILE* f = fopen(tmpPath.c_str(), "wb");
+  if (!f) {
+    fprintf(stderr, "could not write %s\n", tmpPath.c_str());
+    return false;
+  }
+  fwrite(&header, sizeof(header), 1, f);
+  fwrite(entries.data(), sizeof(AssetSectionEntry), entries.size(), f);
+  for (size_t i = 0; i < this->sections.size(); i++) {
+    static const char zeros[16] = {};
+    fwrite(zeros, 1, entries[i].offset - ftell(f), f);
+    fwrite(this->sections[i].data.data(), 1, entries[i].size, f);
+  }
+  bool ok = !ferror(f);
+  ok = fclose(f) == 0 && ok;
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    fprintf(stderr, "could not write %s\n", path.c_str());
+    remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+AssetFile::~AssetFile() {
+  unmap();
+}
+
+void AssetFile::unmap() {
+  if (this->base) {
+    munmap(this->base, this->size);
+  }
+  this->base = NULL;
+  this->size = 0;
+  this->headers.clear();
+  this->bgCamLists.clear();
+  this->loaded.clear();
+}
+
+bool AssetFile::open(const std::string& path) {
+  unmap();
+  this->path = path;
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(AssetFileHeader)) {
+    fprintf(stderr, "%s is not an asset file\n", path.c_str());
+    close(fd);
+    return false;
+  }
+  void* base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                    0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    fprintf(stderr, "could not map %s\n", path.c_str());
+    return false;
+  }
+  this->base = (u8*)base;
+  this->size = st.st_size;
+
+  AssetFileHeader header;
+  memcpy(&header, this->base, sizeof(header));
+  if (memcmp(header.magic, ASSET_MAGIC, sizeof(header.magic)) != 0) {
+    fprintf(stderr, "%s is not an asset file\n", path.c_str());
+    unmap();
+    return false;
+  }
+  if (header.version != ASSET_FILE_VERSION) {
+    fprintf(stderr, "%s has version %u, expected %u\n", path.c_str(),
+            header.version, ASSET_FILE_VERSION);
+    unmap();
+    return false;
+  }
+  if (header.numSections >
+      (this->size - sizeof(header)) / sizeof(AssetSectionEntry)) {
+    fprintf(stderr, "%s is truncated\n", path.c_str());
+    unmap();
+    return false;
+  }
+  const AssetSectionEntry* entries =
+      (const AssetSectionEntry*)(this->base + sizeof(header));
+  for (u32 i = 0; i < header.numSections; i++) {
+    if (entries[i].offset > this->size ||
+        entries[i].size > this->size - entries[i].offset) {
+      fprintf(stderr, "%s is truncated\n", path.c_str());
+      unmap();
+      return false;
+    }
+  }
+  return true;
+}
+
+u8* AssetFile::find(const std::string& name, AssetSectionType type,
+                    size_t* size) const {
+  if (!this->base) {
+    return NULL;
+  }
+  AssetFileHeader header;
+  memcpy(&header, this->base, sizeof(header));
+  const AssetSectionEntry* entries =
+      (const AssetSectionEntry*)(this->base + sizeof(header));
+  for (u32 i = 0; i < header.numSections; i++) {
+    if (entries[i].type == type &&
+        strncmp(entries[i].name, name.c_str(), sizeof(entries[i].name)) == 0) {
+      *size = entries[i].size;
+      return this->base + entries[i].offset;
+    }
+  }
+  return NULL;
+}
+
+CollisionHeader* AssetFile::collision(const std::string& name) {
+  for (const auto& [loadedName, header] : this->loaded) {
+    if (loadedName == name) {
+      return header;
+    }
+  }
+
+  size_t size;
+  u8* data = find(name, ASSET_COLLISION, &size);
+  if (!data) {
+    fprintf(stderr, "%s: no collision named %s\n", this->path.c_str(),
+            name.c_str());
+    return NULL;
+  }
+  AssetCollision col;
+  if (size < sizeof(col)) {
+    fprintf(stderr, "%s: collision %s is truncated\n", this->path.c_str(),
+            name.c_str());
+    return NULL;
+  }
+  memcpy(&col, data, sizeof(col));
+  auto fits = [&](u32 offset, u32 count, size_t elementSize) {
+    return offset <= size && count <= (size - offset) / elementSize;
+  };
+  if (!fits(col.verticesOffset, col.numVertices, sizeof(Vec3s)) ||
+      !fits(col.polysOffset, col.numPolys, sizeof(CollisionPoly)) ||
+      !fits(col.surfaceTypesOffset, col.numSurfaceTypes,
+            sizeof(SurfaceType)) ||
+      !fits(col.bgCamsOffset, col.numBgCams, sizeof(AssetBgCam)) ||
+      !fits(col.waterBoxesOffset, col.numWaterBoxes, sizeof(WaterBox))) {
+    fprintf(stderr, "%s: collision %s is truncated\n", this->path.c_str(),
+            name.c_str());
+    return NULL;
+  }
+
+  std::vector<BgCamInfo>* bgCams = &this->bgCamLists.emplace_back();
+  const AssetBgCam* bgCamData = (const AssetBgCam*)(data + col.bgCamsOffset);
+  for (u32 i = 0; i < col.numBgCams; i++) {
+    bgCams->push_back({bgCamData[i].setting, bgCamData[i].count, NULL});
+  }
+
+  CollisionHeader* header = &this->headers.emplace_back();
+  header->minBound = col.minBound;
+  header->maxBound = col.maxBound;
+  header->numVertices = col.numVertices;
+  header->vertices = (Vec3s*)(data + col.verticesOffset);
+  header->numPolys = col.numPolys;
+  header->polys = (CollisionPoly*)(data + col.polysOffset);
+  header->surfaceTypeList = (SurfaceType*)(data + col.surfaceTypesOffset);
+  header->bgCamList = bgCams->empty() ? NULL : bgCams->data();
+  header->numWaterBoxes = col.numWaterBoxes;
+  header->waterBoxes = (WaterBox*)(data + col.waterBoxesOffset);
+  this->loaded.push_back({name, header});
+  return header;
+}
+
+std::shared_ptr<StaticCollision> AssetFile::staticCollision(
+    const std::string& name) {
+  size_t size;
+  u8* data = find(name, ASSET_STATIC_COLLISION, &size);
+  if (!data) {
+    fprintf(stderr, "%s: no static collision named %s\n", this->path.c_str(),
+            name.c_str());
+    return NULL;
+  }
+  AssetReader r = {data, data + size};
+
+  std::vector<char> collisionName;
+  r.getVector(&collisionName);
+  if (!r.ok) {
+    fprintf(stderr, "%s: static collision %s is truncated\n",
+            this->path.c_str(), name.c_str());
+    return NULL;
+  }
+  CollisionHeader* header =
+      collision(std::string(collisionName.begin(), collisionName.end()));
+  if (!header) {
+    return NULL;
+  }
+
+  // The grids are read from the file
+  auto scene = std::make_shared<StaticCollision>(header, 0.0f);
+  auto getPolys = [&](std::vector<CollisionPoly*>* polys) {
+    std::vector<s32> indices;
+    r.getVector(&indices);
+    for (s32 index : indices) {
+      if (index < 0 || index >= header->numPolys) {
+        r.ok = false;
+        return;
+      }
+      polys->push_back(&header->polys[index]);
+    }
+  };
+  getPolys(&scene->walls);
+  getPolys(&scene->floors);
+  getPolys(&scene->ceilings);
+
+  for (StaticPolyCache* cache :
+       {&scene->wallCache, &scene->floorCache, &scene->ceilingCache}) {
+    StaticPolyCache_ForEachArray(cache, [&](auto& v) { r.getVector(&v); });
+  }
+  auto inList = [](const std::vector<CollisionPoly*>& polys) {
+    return [&](s32 index) {
+      return index >= 0 && (size_t)index < polys.size();
+    };
+  };
+  StaticGrid_Get(&r, inList(scene->walls), &scene->wallGrid);
+  StaticGrid_Get(&r, inList(scene->floors), &scene->floorGrid);
+  StaticGrid_Get(&r, inList(scene->ceilings), &scene->ceilingGrid);
+  const std::vector<CollisionPoly*>* cameraLists[] = {
+      &scene->floors, &scene->walls, &scene->ceilings};
+  StaticGrid_Get(
+      &r,
+      [&](s32 key) {
+        int list = STATIC_CAMERA_LIST(key);
+        return key >= 0 && list <= STATIC_CAMERA_CEILINGS &&
+               (size_t)STATIC_CAMERA_INDEX(key) < cameraLists[list]->size();
+      },
+      &scene->cameraGrid);
+
+  if (!r.ok ||
+      !StaticPolyCache_HasPolys(&scene->wallCache, scene->walls.size()) ||
+      !StaticPolyCache_HasPolys(&scene->floorCache, scene->floors.size()) ||
+      !StaticPolyCache_HasPolys(&scene->ceilingCache,
+                                scene->ceilings.size())) {
+    fprintf(stderr, "%s: static collision %s is corrupt\n", this->path.c_str(),
+            name.c_str());
+    return NULL;
+  }
+  return scene;
+}
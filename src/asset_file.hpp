@@ -0,0 +1,102 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "collision.hpp"
+#include "global.hpp"
+
+// Asset files hold data that would otherwise be compiled into every program:
+// collision meshes, static scenes with their grids and poly caches already
+// built, and plain tables such as cameraAngles. A file is a list of named
+// sections and is loaded with mmap, so opening one costs about the same no
+// matter how large it is. Data is stored in the in-memory layout of this
+// build, and files from a different ASSET_FILE_VERSION are rejected.
+#define ASSET_FILE_VERSION 2
+
+enum AssetSectionType : u32 {
+  ASSET_DATA = 1,
+  ASSET_COLLISION = 2,
+  ASSET_STATIC_COLLISION = 3,
+};
+
+// Builds an asset file in memory.
+struct AssetWriter {
+  struct Section {
+    std::string name;
+    AssetSectionType type;
+    std::string data;
+  };
+
+  std::vector<Section> sections;
+  // Collision headers that have been added, so static scenes can refer to them
+  std::vector<std::pair<const CollisionHeader*, std::string>> collisions;
+
+  // Adds raw bytes
+  void addData(const std::string& name, const void* data, size_t size);
+  template <typename T>
+  void addArray(const std::string& name, const T* data, size_t count) {
+    addData(name, data, count * sizeof(T));
+  }
+  // Adds a collision mesh. Camera data other than the settings is not stored.
+  void addCollision(const std::string& name, const CollisionHeader* header);
+  // Adds a static scene. Its collision header must have been added first.
+  bool addStaticCollision(const std::string& name,
+                          const StaticCollision* scene);
+
+  bool write(const std::string& path) const;
+};
+
+// A mapped asset file. Everything returned by it points into the mapping, so
+// it must outlive any data, collision headers and scenes loaded from it.
+// Pages are mapped copy-on-write, so loaded data can be modified (e.g. to move
+// the vertices of a mesh) without changing the file.
+struct AssetFile {
+  std::string path;
+  u8* base = NULL;
+  size_t size = 0;
+  // Headers built for the collision sections that have been loaded
+  std::deque<CollisionHeader> headers;
+  std::deque<std::vector<BgCamInfo>> bgCamLists;
+  std::vector<std::pair<std::string, CollisionHeader*>> loaded;
+
+  AssetFile() = default;
+  ~AssetFile();
+
+  AssetFile(const AssetFile&) = delete;
+  AssetFile& operator=(const AssetFile&) = delete;
+
+  // Maps a file, unmapping any file opened before. Returns false and prints an
+  // error if it can't be read or was written by a different version, and
+  // leaves nothing mapped.
+  bool open(const std::string& path);
+  // Unmaps the file. Everything loaded from it becomes invalid.
+  void unmap();
+
+  // Returns the section with the given name and type, or NULL if there is
+  // none.
+  u8* find(const std::string& name, AssetSectionType type,
+           size_t* size) const;
+  // Returns a data section as an array, or NULL and prints an error if it is
+  // missing.
+  template <typename T>
+  T* array(const std::string& name, size_t* count) const {
+    size_t bytes;
+    u8* data = find(name, ASSET_DATA, &bytes);
+    if (!data) {
+      fprintf(stderr, "%s: no data named %s\n", this->path.c_str(),
+              name.c_str());
+      return NULL;
+    }
+    *count = bytes / sizeof(T);
+    return (T*)data;
+  }
+  // Returns a collision mesh, or NULL and prints an error if it is missing.
+  // Loading the same mesh twice returns the same header.
+  CollisionHeader* collision(const std::string& name);
+  // Returns a static scene, or NULL and prints an error if it is missing.
+  // Each call returns a new copy that can be shared by Collisions.
+  std::shared_ptr<StaticCollision> staticCollision(const std::string& name);
+};
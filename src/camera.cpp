@@ -1,5 +1,7 @@
 #include "camera.hpp"
 
+#include <vector>
+
 #include "camera_data.hpp"
 #include "olib.hpp"
 #include "sys_math.hpp"
@@ -128,36 +130,102 @@ Vec3f* Camera_AddVecGeoToVec3f(Vec3f* dest, Vec3f* a, VecGeo* geo) {
   return dest;
 }
 
-bool Camera_BGCheckInfo(Camera* camera, Vec3f from, Vec3f to, Vec3f* result,
-                        Vec3f* normal) {
+// A camera update split at its collision tests, so that the tests of many
+// cameras can be done together. Each stage runs until it needs the results of
+// the tests it sets up, and the next stage continues from there.
+enum CameraStage {
+  CAMERA_STAGE_DONE,
+  CAMERA_STAGE_NORMAL1_EYE,
+  CAMERA_STAGE_NORMAL1_COLLISION,
+  CAMERA_STAGE_PARALLEL1_COLLISION,
+};
+
+struct CameraUpdate {
+  Camera* camera;
+  Vec3f pos;
+  u16 angle;
+  int setting;
+  CameraStage stage = CAMERA_STAGE_DONE;
+
+  // Tests set up by the last stage and their results. A stage sets up either
+  // a line test or one or two floor tests.
+  bool lineTest = false;
+  Vec3f lineFrom;
+  Vec3f lineTo;
+  Vec3f lineResult;
+  CollisionPoly* linePoly;
+  int numFloorTests = 0;
+  Vec3f floorPos[2];
+  f32 floorY[2];
+  CollisionPoly* floorPoly[2];
+
+  // Variables kept between stages
+  Vec3f bgCheckTo;
+  VecGeo atEyeNextGeo;
+  VecGeo eyeAdjustment;
+  f32 playerGroundY;
+  f32 nearDist;
+  f32 farDist;
+
+  CameraUpdate(Camera* camera) : camera(camera) {}
+  CameraUpdate(Camera* camera, Vec3f pos, u16 angle, int setting)
+      : camera(camera), pos(pos), angle(angle), setting(setting) {}
+};
+
+// Runs the tests set up by the last stage.
+static void Camera_RunTests(CameraUpdate* u) {
+  Collision* col = u->camera->col;
+  if (u->lineTest) {
+    u->lineResult = col->cameraLineTest(u->lineFrom, u->lineTo, &u->linePoly);
+  }
+  for (int k = 0; k < u->numFloorTests; k++) {
+    u->floorY[k] = col->cameraFindFloor(u->floorPos[k], &u->floorPoly[k]);
+  }
+}
+
+// Sets up the line test for Camera_BGCheckInfo, which goes 8 units past `to`.
+static void Camera_BGCheckInfoStart(CameraUpdate* u, Vec3f from, Vec3f to) {
   VecGeo fromToOffset = OLib_Vec3fDiffToVecGeo(&from, &to);
   fromToOffset.r += 8.0f;
 
   Vec3f toPoint;
   Camera_AddVecGeoToVec3f(&toPoint, &from, &fromToOffset);
 
-  Vec3f lineResult =
-      camera->col->cameraLineTest(from, toPoint, &camera->wallPoly);
+  u->lineTest = true;
+  u->numFloorTests = 0;
+  u->lineFrom = from;
+  u->lineTo = toPoint;
+  u->bgCheckTo = to;
+}
+
+static bool Camera_BGCheckInfoFinish(CameraUpdate* u, Vec3f* result,
+                                     Vec3f* normal) {
+  Camera* camera = u->camera;
+  camera->wallPoly = u->linePoly;
 
   if (camera->wallPoly) {
     *normal = CollisionPoly_GetNormalF(camera->wallPoly);
-    *result = lineResult + *normal;
+    *result = u->lineResult + *normal;
     return true;
   } else {
     // TODO: check floors
-    Vec3f fromToNorm = OLib_Vec3fDistNormalize(&from, &to);
+    Vec3f fromToNorm = OLib_Vec3fDistNormalize(&u->lineFrom, &u->bgCheckTo);
     *normal = fromToNorm * -1.0f;
-    *result = to + *normal;
+    *result = u->bgCheckTo + *normal;
     return false;
   }
 }
 
-void Camera_UpdateCollision(Camera* camera, VecGeo* eyeAdjustment, f32 distMin, f32 yawUpdateRateTarget) {
+// Finishes Camera_UpdateCollision after Camera_BGCheckInfoStart from at to
+// eyeNext.
+static void Camera_UpdateCollisionFinish(CameraUpdate* u,
+                                         VecGeo* eyeAdjustment, f32 distMin,
+                                         f32 yawUpdateRateTarget) {
+  Camera* camera = u->camera;
   Vec3f collisionPoint;
   Vec3f collisionNormal;
   // TODO: check both ways?
-  if (Camera_BGCheckInfo(camera, camera->at, camera->eyeNext, &collisionPoint,
-                         &collisionNormal)) {
+  if (Camera_BGCheckInfoFinish(u, &collisionPoint, &collisionNormal)) {
     VecGeo geoNorm = OLib_Vec3fToVecGeo(&collisionNormal);
     if (geoNorm.pitch >= 0x2EE1) {
       geoNorm.yaw = eyeAdjustment->yaw;
@@ -183,8 +251,19 @@ void Camera_UpdateCollision(Camera* camera, VecGeo* eyeAdjustment, f32 distMin,
   }
 }
 
-f32 Camera_GetFloorYLayer(Camera* camera, Vec3f pos, f32 playerGroundY) {
-  f32 floorY = camera->col->cameraFindFloor(pos, &camera->floorPoly);
+void Camera_UpdateCollision(Camera* camera, VecGeo* eyeAdjustment, f32 distMin, f32 yawUpdateRateTarget) {
+  CameraUpdate u(camera);
+  Camera_BGCheckInfoStart(&u, camera->at, camera->eyeNext);
+  Camera_RunTests(&u);
+  Camera_UpdateCollisionFinish(&u, eyeAdjustment, distMin,
+                               yawUpdateRateTarget);
+}
+
+// Finishes Camera_GetFloorYLayer with the result of its floor test.
+static f32 Camera_GetFloorYLayerFinish(Camera* camera, f32 floorY,
+                                       CollisionPoly* floorPoly,
+                                       f32 playerGroundY) {
+  camera->floorPoly = floorPoly;
   if (camera->floorPoly) {
     Vec3f normal = CollisionPoly_GetNormalF(camera->floorPoly);
     if (playerGroundY < floorY && normal.y <= 0.5f) {
@@ -195,7 +274,11 @@ f32 Camera_GetFloorYLayer(Camera* camera, Vec3f pos, f32 playerGroundY) {
   return floorY;
 }
 
-s16 Camera_GetPitchAdjFromFloorHeightDiffs(Camera* camera, s16 viewYaw) {
+// Sets up the collision tests for Camera_GetPitchAdjFromFloorHeightDiffs: a
+// line test on even frames, and one or two floor tests on odd frames.
+static void Camera_GetPitchAdjFromFloorHeightDiffsStart(CameraUpdate* u,
+                                                        s16 viewYaw) {
+  Camera* camera = u->camera;
   // TODO: we assume player is standing on ground
   f32 playerGroundY = camera->playerPos.y;
 
@@ -210,24 +293,49 @@ s16 Camera_GetPitchAdjFromFloorHeightDiffs(Camera* camera, s16 viewYaw) {
 
   if (camera->frames % 2 == 0) {
     Vec3f testPos = playerPos + viewForwards * farDist;
-    Camera_BGCheckInfo(camera, playerPos, testPos, &camera->pitchTestPos,
-                       &camera->pitchTestNormal);
+    Camera_BGCheckInfoStart(u, playerPos, testPos);
   } else {
     farDist = OLib_Vec3fDistXZ(&playerPos, &camera->pitchTestPos);
     camera->pitchTestPos =
         camera->pitchTestPos + camera->pitchTestNormal * 5.0f;
 
+    u->lineTest = false;
     if (nearDist > farDist) {
       nearDist = farDist;
-      camera->floorYNear = camera->floorYFar =
-          Camera_GetFloorYLayer(camera, camera->pitchTestPos, playerGroundY);
+      u->numFloorTests = 1;
+      u->floorPos[0] = camera->pitchTestPos;
     } else {
       Vec3f nearPos = playerPos + viewForwards * nearDist;
 
-      camera->floorYNear =
-          Camera_GetFloorYLayer(camera, nearPos, playerGroundY);
-      camera->floorYFar =
-          Camera_GetFloorYLayer(camera, camera->pitchTestPos, playerGroundY);
+      u->numFloorTests = 2;
+      u->floorPos[0] = nearPos;
+      u->floorPos[1] = camera->pitchTestPos;
+    }
+  }
+
+  u->playerGroundY = playerGroundY;
+  u->nearDist = nearDist;
+  u->farDist = farDist;
+}
+
+static s16 Camera_GetPitchAdjFromFloorHeightDiffsFinish(CameraUpdate* u) {
+  Camera* camera = u->camera;
+  f32 playerGroundY = u->playerGroundY;
+  f32 nearDist = u->nearDist;
+  f32 farDist = u->farDist;
+
+  if (camera->frames % 2 == 0) {
+    Camera_BGCheckInfoFinish(u, &camera->pitchTestPos,
+                             &camera->pitchTestNormal);
+  } else {
+    if (u->numFloorTests == 1) {
+      camera->floorYNear = camera->floorYFar = Camera_GetFloorYLayerFinish(
+          camera, u->floorY[0], u->floorPoly[0], playerGroundY);
+    } else {
+      camera->floorYNear = Camera_GetFloorYLayerFinish(
+          camera, u->floorY[0], u->floorPoly[0], playerGroundY);
+      camera->floorYFar = Camera_GetFloorYLayerFinish(
+          camera, u->floorY[1], u->floorPoly[1], playerGroundY);
     }
 
     if (camera->floorYNear == BGCHECK_Y_MIN) {
@@ -422,21 +530,42 @@ void Camera::initParallel(Vec3f pos, u16 angle, int setting) {
   this->floorPoly = NULL;
 }
 
-void Camera_Normal1(Camera* camera, Vec3f pos, u16 angle, int setting) {
+struct CameraNormal1Params {
+  f32 yOffset;
+  f32 distMin;
+  f32 distMax;
+  f32 pitchTarget;
+  f32 yawUpdateRateTarget;
+  f32 pitchUpdateRateTarget;
+  f32 maxYawUpdate;
+  f32 atLERPScaleMax;
+};
+
+static CameraNormal1Params Camera_GetNormal1Params(Camera* camera,
+                                                   int setting) {
   CameraNormalSettings* settings = &cameraNormalSettings[setting];
   f32 yNormal = 1.0f - 0.1f - (-0.1f * (68.0f / camera->playerHeight));
   f32 t = yNormal * (camera->playerHeight * 0.01f);
-  f32 yOffset = settings->yOffset * t;
-  f32 distMin = settings->distMin * t;
-  f32 distMax = settings->distMax * t;
-  f32 pitchTarget = CAM_DEG_TO_BINANG(settings->pitchTarget);
-  f32 yawUpdateRateTarget = settings->yawUpdateRateTarget;
-  f32 pitchUpdateRateTarget = settings->pitchUpdateRateTarget;
-  f32 maxYawUpdate = CAM_DATA_SCALED(settings->maxYawUpdate);
-  f32 atLERPScaleMax = CAM_DATA_SCALED(settings->atLerpStepScale);
+  CameraNormal1Params params;
+  params.yOffset = settings->yOffset * t;
+  params.distMin = settings->distMin * t;
+  params.distMax = settings->distMax * t;
+  params.pitchTarget = CAM_DEG_TO_BINANG(settings->pitchTarget);
+  params.yawUpdateRateTarget = settings->yawUpdateRateTarget;
+  params.pitchUpdateRateTarget = settings->pitchUpdateRateTarget;
+  params.maxYawUpdate = CAM_DATA_SCALED(settings->maxYawUpdate);
+  params.atLERPScaleMax = CAM_DATA_SCALED(settings->atLerpStepScale);
+  return params;
+}
+
+static void Camera_Normal1Start(CameraUpdate* u) {
+  Camera* camera = u->camera;
+  u16 angle = u->angle;
+  int setting = u->setting;
+  CameraNormal1Params params = Camera_GetNormal1Params(camera, setting);
 
   VecGeo atEyeGeo = OLib_Vec3fDiffToVecGeo(&camera->at, &camera->eye);
-  VecGeo atEyeNextGeo = OLib_Vec3fDiffToVecGeo(&camera->at, &camera->eyeNext);
+  u->atEyeNextGeo = OLib_Vec3fDiffToVecGeo(&camera->at, &camera->eyeNext);
 
   if (camera->mode != 0 || setting != camera->setting) {
     camera->setting = setting;
@@ -444,7 +573,7 @@ void Camera_Normal1(Camera* camera, Vec3f pos, u16 angle, int setting) {
 
     camera->normalPrevXZSpeed = camera->xzSpeed;
     camera->normalRUpdateRateTimer = 10;
-    camera->normalYawUpdateRateTarget = yawUpdateRateTarget;
+    camera->normalYawUpdateRateTarget = params.yawUpdateRateTarget;
     camera->normalSlopePitchAdj = 0;
     camera->normalSwingYawTarget = atEyeGeo.yaw;
     camera->normalStartSwingTimer = 40;
@@ -463,19 +592,29 @@ void Camera_Normal1(Camera* camera, Vec3f pos, u16 angle, int setting) {
     camera->normalStartSwingTimer--;
   }
 
-  s16 slopePitchTarget =
-      Camera_GetPitchAdjFromFloorHeightDiffs(camera, atEyeGeo.yaw - 0x7FFF);
+  Camera_GetPitchAdjFromFloorHeightDiffsStart(u, atEyeGeo.yaw - 0x7FFF);
+  u->stage = CAMERA_STAGE_NORMAL1_EYE;
+}
+
+static void Camera_Normal1Eye(CameraUpdate* u) {
+  Camera* camera = u->camera;
+  u16 angle = u->angle;
+  CameraNormal1Params params = Camera_GetNormal1Params(camera, u->setting);
+  VecGeo atEyeNextGeo = u->atEyeNextGeo;
+
+  s16 slopePitchTarget = Camera_GetPitchAdjFromFloorHeightDiffsFinish(u);
   f32 pitchAdjStep =
-      ((1.0f / pitchUpdateRateTarget) * 0.5f) +
-      ((1.0f / pitchUpdateRateTarget) * 0.5f) * (1.0f - camera->speedRatio);
+      ((1.0f / params.pitchUpdateRateTarget) * 0.5f) +
+      ((1.0f / params.pitchUpdateRateTarget) * 0.5f) *
+          (1.0f - camera->speedRatio);
   camera->normalSlopePitchAdj = Camera_LERPCeilS(
       slopePitchTarget, camera->normalSlopePitchAdj, pitchAdjStep, 15);
 
-  Camera_CalcAtDefault(camera, yOffset);
+  Camera_CalcAtDefault(camera, params.yOffset);
 
   VecGeo eyeAdjustment = OLib_Vec3fDiffToVecGeo(&camera->at, &camera->eyeNext);
 
-  Camera_ClampDist(camera, eyeAdjustment.r, distMin, distMax,
+  Camera_ClampDist(camera, eyeAdjustment.r, params.distMin, params.distMax,
                    camera->normalRUpdateRateTimer);
   eyeAdjustment.r = camera->dist;
 
@@ -505,10 +644,11 @@ void Camera_Normal1(Camera* camera, Vec3f pos, u16 angle, int setting) {
         camera->normalSwingYawTarget, atEyeNextGeo.yaw, 1.0f / camera->yawUpdateRateInv, 10);
     eyeAdjustment.pitch = atEyeNextGeo.pitch;
   } else {
-    eyeAdjustment.yaw = Camera_CalcDefaultYaw(camera, atEyeNextGeo.yaw, angle,
-                                              maxYawUpdate, accel);
+    eyeAdjustment.yaw = Camera_CalcDefaultYaw(
+        camera, atEyeNextGeo.yaw, angle, params.maxYawUpdate, accel);
     eyeAdjustment.pitch = Camera_CalcDefaultPitch(
-      camera, atEyeNextGeo.pitch, pitchTarget, camera->normalSlopePitchAdj);
+        camera, atEyeNextGeo.pitch, params.pitchTarget,
+        camera->normalSlopePitchAdj);
   }
 
   if (eyeAdjustment.pitch > 0x38A4) {
@@ -522,24 +662,40 @@ void Camera_Normal1(Camera* camera, Vec3f pos, u16 angle, int setting) {
 
   camera->normalSwingYawTarget = angle - 0x7FFF;
 
+  u->eyeAdjustment = eyeAdjustment;
+  Camera_BGCheckInfoStart(u, camera->at, camera->eyeNext);
+  u->stage = CAMERA_STAGE_NORMAL1_COLLISION;
+}
+
+static void Camera_Normal1Collision(CameraUpdate* u) {
+  Camera* camera = u->camera;
+  CameraNormal1Params params = Camera_GetNormal1Params(camera, u->setting);
+
   if (camera->normalStartSwingTimer > 0) {
-    Camera_UpdateCollision(camera, &eyeAdjustment, distMin, yawUpdateRateTarget);
+    Camera_UpdateCollisionFinish(u, &u->eyeAdjustment, params.distMin,
+                                 params.yawUpdateRateTarget);
   } else {
     Vec3f result;
     Vec3f normal;
-    camera->normalYawUpdateRateTarget = camera->yawUpdateRateInv = yawUpdateRateTarget * 2.0f;
-    if (Camera_BGCheckInfo(camera, camera->at, camera->eyeNext, &result, &normal)) {
-      camera->normalSwingYawTarget = atEyeNextGeo.yaw;
+    camera->normalYawUpdateRateTarget = camera->yawUpdateRateInv =
+        params.yawUpdateRateTarget * 2.0f;
+    if (Camera_BGCheckInfoFinish(u, &result, &normal)) {
+      camera->normalSwingYawTarget = u->atEyeNextGeo.yaw;
       camera->normalStartSwingTimer = -1;
     } else {
       camera->eye = camera->eyeNext;
     }
   }
 
-  camera->atLERPStepScale = Camera_ClampLERPScale(camera, atLERPScaleMax);
+  camera->atLERPStepScale =
+      Camera_ClampLERPScale(camera, params.atLERPScaleMax);
+  u->stage = CAMERA_STAGE_DONE;
 }
 
-void Camera_Parallel1(Camera* camera, Vec3f pos, u16 angle, int setting) {
+static void Camera_Parallel1Start(CameraUpdate* u) {
+  Camera* camera = u->camera;
+  u16 angle = u->angle;
+  int setting = u->setting;
   CameraZParallelSettings* settings = &cameraZParallelSettings[setting];
   f32 yNormal = 1.0f - 0.1f - (-0.1f * (68.0f / camera->playerHeight));
   f32 yOffset =
@@ -547,7 +703,6 @@ void Camera_Parallel1(Camera* camera, Vec3f pos, u16 angle, int setting) {
   f32 distTarget =
       CAM_DATA_SCALED(settings->dist) * camera->playerHeight * yNormal;
   f32 yawUpdateRateTarget = settings->yawUpdateRateTarget;
-  f32 atLerpStepScale = CAM_DATA_SCALED(settings->atLerpStepScale);
 
   if (camera->mode != 1 || setting != camera->setting) {
     camera->setting = setting;
@@ -609,13 +764,22 @@ void Camera_Parallel1(Camera* camera, Vec3f pos, u16 angle, int setting) {
 
   // TODO: if skyboxDisabled, call func_80043F94, which also checks if camera
   // view does not go through the floor poly that the player is on?
+  Camera_BGCheckInfoStart(u, camera->at, camera->eyeNext);
+  u->stage = CAMERA_STAGE_PARALLEL1_COLLISION;
+}
+
+static void Camera_Parallel1Collision(CameraUpdate* u) {
+  Camera* camera = u->camera;
+  CameraZParallelSettings* settings = &cameraZParallelSettings[u->setting];
+  f32 atLerpStepScale = CAM_DATA_SCALED(settings->atLerpStepScale);
+
   Vec3f collisionPoint;
   Vec3f collisionNormal;
-  Camera_BGCheckInfo(camera, camera->at, camera->eyeNext, &collisionPoint,
-                     &collisionNormal);
+  Camera_BGCheckInfoFinish(u, &collisionPoint, &collisionNormal);
   camera->eye = collisionPoint;
 
   camera->atLERPStepScale = Camera_ClampLERPScale(camera, atLerpStepScale);
+  u->stage = CAMERA_STAGE_DONE;
 }
 
 void Camera_Jump1(Camera* camera, Vec3f pos, u16 angle, int setting) {
@@ -679,29 +843,136 @@ void Camera_Jump1(Camera* camera, Vec3f pos, u16 angle, int setting) {
   camera->atLERPStepScale = Camera_ClampLERPScale(camera, atLERPScaleMax);
 }
 
-void Camera::update(Vec3f pos, u16 angle, int setting, int mode) {
-  this->frames++;
+// Runs the first stage of an update.
+static void Camera_UpdateStart(CameraUpdate* u, int mode) {
+  Camera* camera = u->camera;
+  Vec3f pos = u->pos;
+  camera->frames++;
 
-  this->prevPlayerPos = this->playerPos;
-  this->playerPos = pos;
-  this->xzSpeed = OLib_Vec3fDistXZ(&pos, &this->prevPlayerPos);
-  this->speedRatio = OLib_ClampMaxDist(this->xzSpeed / 9.0f, 1.0f);
+  camera->prevPlayerPos = camera->playerPos;
+  camera->playerPos = pos;
+  camera->xzSpeed = OLib_Vec3fDistXZ(&pos, &camera->prevPlayerPos);
+  camera->speedRatio = OLib_ClampMaxDist(camera->xzSpeed / 9.0f, 1.0f);
 
-  if (this->modeChangeDisallowed) {
-    mode = this->mode;
+  if (camera->modeChangeDisallowed) {
+    mode = camera->mode;
   }
-  this->modeChangeDisallowed = false;
+  camera->modeChangeDisallowed = false;
 
   switch (mode) {
     case 0:
-      Camera_Normal1(this, pos, angle, setting);
+      Camera_Normal1Start(u);
       break;
     case 1:
-      Camera_Parallel1(this, pos, angle, setting);
+      Camera_Parallel1Start(u);
       break;
     case 13:
-      Camera_Jump1(this, pos, angle, setting);
+      // Rare enough that it doesn't need to be split into stages
+      Camera_Jump1(camera, pos, u->angle, u->setting);
+      break;
+  }
+}
+
+// Runs the next stage of an update, once the tests set up by the last one
+// have been run.
+static void Camera_UpdateContinue(CameraUpdate* u) {
+  switch (u->stage) {
+    case CAMERA_STAGE_DONE:
+      break;
+    case CAMERA_STAGE_NORMAL1_EYE:
+      Camera_Normal1Eye(u);
+      break;
+    case CAMERA_STAGE_NORMAL1_COLLISION:
+      Camera_Normal1Collision(u);
       break;
+    case CAMERA_STAGE_PARALLEL1_COLLISION:
+      Camera_Parallel1Collision(u);
+      break;
+  }
+}
+
+void Camera::update(Vec3f pos, u16 angle, int setting, int mode) {
+  CameraUpdate u(this, pos, angle, setting);
+  Camera_UpdateStart(&u, mode);
+  while (u.stage != CAMERA_STAGE_DONE) {
+    Camera_RunTests(&u);
+    Camera_UpdateContinue(&u);
+  }
+}
+
+void Camera::updateBatch(Camera* cameras, const Vec3f* pos, const u16* angles,
+                         int setting, int mode, int count) {
+  static thread_local std::vector<CameraUpdate> updates;
+  // Tests of all cameras, and the update each one belongs to
+  static thread_local std::vector<Vec3f> lineFrom;
+  static thread_local std::vector<Vec3f> lineTo;
+  static thread_local std::vector<Vec3f> lineResults;
+  static thread_local std::vector<CollisionPoly*> linePolys;
+  static thread_local std::vector<int> lineOwners;
+  static thread_local std::vector<Vec3f> floorPos;
+  static thread_local std::vector<CollisionCheckResult> floorResults;
+  static thread_local std::vector<std::pair<int, int>> floorOwners;
+
+  if (count == 0) {
+    return;
+  }
+  Collision* col = cameras[0].col;
+
+  updates.clear();
+  for (int j = 0; j < count; j++) {
+    updates.emplace_back(&cameras[j], pos[j], angles[j], setting);
+    Camera_UpdateStart(&updates[j], mode);
+  }
+
+  while (true) {
+    lineFrom.clear();
+    lineTo.clear();
+    lineOwners.clear();
+    floorPos.clear();
+    floorOwners.clear();
+    for (int j = 0; j < count; j++) {
+      CameraUpdate* u = &updates[j];
+      if (u->stage == CAMERA_STAGE_DONE) {
+        continue;
+      }
+      if (u->lineTest) {
+        lineFrom.push_back(u->lineFrom);
+        lineTo.push_back(u->lineTo);
+        lineOwners.push_back(j);
+      }
+      for (int k = 0; k < u->numFloorTests; k++) {
+        floorPos.push_back(u->floorPos[k]);
+        floorOwners.push_back({j, k});
+      }
+    }
+    if (lineOwners.empty() && floorOwners.empty()) {
+      break;
+    }
+
+    int numLines = lineOwners.size();
+    lineResults.resize(numLines);
+    linePolys.resize(numLines);
+    col->cameraLineTests(lineFrom.data(), lineTo.data(), lineResults.data(),
+                         linePolys.data(), numLines);
+    for (int i = 0; i < numLines; i++) {
+      CameraUpdate* u = &updates[lineOwners[i]];
+      u->lineResult = lineResults[i];
+      u->linePoly = linePolys[i];
+    }
+
+    int numFloors = floorOwners.size();
+    floorResults.resize(numFloors);
+    col->findFloors(floorPos.data(), floorResults.data(), numFloors);
+    for (int i = 0; i < numFloors; i++) {
+      CameraUpdate* u = &updates[floorOwners[i].first];
+      int k = floorOwners[i].second;
+      u->floorY[k] = floorResults[i].floorHeight;
+      u->floorPoly[k] = floorResults[i].floorPoly;
+    }
+
+    for (CameraUpdate& u : updates) {
+      Camera_UpdateContinue(&u);
+    }
   }
 }
 
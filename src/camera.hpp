@@ -60,6 +60,12 @@ struct Camera {
 
   // Update the camera.
   void update(Vec3f pos, u16 angle, int setting, int mode);
+  // Update several cameras at once, with the same results as calling update()
+  // on each of them. The collision tests of all cameras are done together,
+  // which is faster for cameras in the same area. The cameras must all use the
+  // same collision.
+  static void updateBatch(Camera* cameras, const Vec3f* pos, const u16* angles,
+                          int setting, int mode, int count);
 
   // Alias for mode 0
   void updateNormal(Vec3f pos, u16 angle, int setting);
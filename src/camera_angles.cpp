@@ -1,7 +1,113 @@
 #include "camera_angles.hpp"
 
-// TODO: Recreate the code that calculated these camera angles (they're from an
-// old project).
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#include "asset_file.hpp"
+#include "collision.hpp"
+
+void buildCameraAngles(u16* table, CameraAngleFunc simulate, int numThreads) {
+  if (numThreads <= 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Interleave the angles so that threads get similar amounts of work even if
+  // some directions are more expensive to simulate than others
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.emplace_back([=] {
+      for (int i = t; i < 0x10000; i += numThreads) {
+        table[i] = simulate(i);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// splitmix64 finalizer
+static u64 mix(u64 h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+static u64 hashPolys(u64 h, const std::vector<CollisionPoly*>& polys,
+                     const Vec3s* vtxList, const SurfaceType* surfaceTypes) {
+  h = mix(h ^ polys.size());
+  for (const CollisionPoly* poly : polys) {
+    u64 words[2];
+    memcpy(words, poly, sizeof(words));
+    h = mix(h ^ words[0]);
+    h = mix(h ^ words[1]);
+    for (u16 v : {poly->v1, poly->v2, poly->v3}) {
+      Vec3s vtx = vtxList[v & 0x1FFF];
+      h = mix(h ^ ((u64)(u16)vtx.x | ((u64)(u16)vtx.y << 16) |
+                   ((u64)(u16)vtx.z << 32)));
+    }
+    if (surfaceTypes) {
+      const SurfaceType* surfaceType = &surfaceTypes[poly->type];
+      h = mix(h ^ (((u64)surfaceType->data[0] << 32) | surfaceType->data[1]));
+    }
+  }
+  return h;
+}
+
+u64 hashCameraInputs(const Collision* col, Vec3f pos, u16 setting) {
+  const StaticCollision* scene = col->scene.get();
+  const SurfaceType* surfaceTypes = scene->header->surfaceTypeList;
+  u64 h = mix(col->age);
+  h = hashPolys(h, scene->walls, scene->vtxList, surfaceTypes);
+  h = hashPolys(h, scene->floors, scene->vtxList, surfaceTypes);
+  h = hashPolys(h, scene->ceilings, scene->vtxList, surfaceTypes);
+  h = mix(h ^ col->dyna.key());
+  h = mix(h ^ (((u64)floatToInt(pos.x) << 32) | floatToInt(pos.y)));
+  h = mix(h ^ (((u64)floatToInt(pos.z) << 32) | setting));
+  return h;
+}
+
+bool loadCameraAngles(const std::string& path, u16* table, u64 inputs,
+                      CameraAngleFunc simulate) {
+  u64 key = mix(inputs ^ mix(CAMERA_CODE_VERSION));
+
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0) {
+    AssetFile file;
+    size_t count = 0;
+    size_t keyCount = 0;
+    u16* data = NULL;
+    u64* savedKey = NULL;
+    if (file.open(path)) {
+      data = file.array<u16>("cameraAngles", &count);
+      savedKey = file.array<u64>("cameraAnglesKey", &keyCount);
+    }
+    if (data && count == 0x10000 && savedKey && keyCount == 1 &&
+        *savedKey == key) {
+      std::copy(data, data + count, table);
+      return true;
+    }
+    fprintf(stderr, "%s is out of date, rebuilding\n", path.c_str());
+  }
+
+  buildCameraAngles(table, simulate);
+
+  AssetWriter writer;
+  writer.addArray("cameraAngles", table, 0x10000);
+  writer.addArray("cameraAnglesKey", &key, 1);
+  return writer.write(path);
+}
+
+// These angles are from an old project and the code that calculated them is
+// lost. Camera::initParallel at the origin only agrees with about 94% of them,
+// so they're kept as they are rather than being regenerated with
+// buildCameraAngles.
 u16 cameraAngles[] = {
     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0010, 0x0010, 0x0010,
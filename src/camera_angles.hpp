@@ -1,6 +1,39 @@
 #pragma once
 
+#include <functional>
+#include <string>
+
 #include "global.hpp"
 
+struct Collision;
+
+// Version of the camera simulation. Bump this whenever a change to the camera
+// code (or the collision code it uses) can change where the camera settles, so
+// that saved camera angle tables are rebuilt.
+#define CAMERA_CODE_VERSION 1
+
 // Precomputed approximate camera angles for each facing angle.
 extern u16 cameraAngles[0x10000];
+
+// Returns the camera angle for a facing angle. Called from several threads at
+// once, so it must not modify shared state.
+typedef std::function<u16(u16 angle)> CameraAngleFunc;
+
+// Fills `table` with the camera angle for each of the 0x10000 facing angles,
+// simulating each one once. The angles are split between numThreads threads,
+// or all hardware threads if numThreads is 0.
+void buildCameraAngles(u16* table, CameraAngleFunc simulate,
+                       int numThreads = 0);
+
+// Loads a camera angle table from the asset file at `path`, or builds it and
+// saves it there if the file is missing or out of date. `inputs` must identify
+// everything `simulate` depends on other than the camera code, e.g. from
+// hashCameraInputs. The table is saved with `inputs` and CAMERA_CODE_VERSION
+// and only loaded if both match. Returns false if the table was built but
+// couldn't be saved.
+bool loadCameraAngles(const std::string& path, u16* table, u64 inputs,
+                      CameraAngleFunc simulate);
+
+// Hashes the inputs of a camera simulated on the given collision (its static
+// polys, surface types and dynapolys) at the given position and setting.
+u64 hashCameraInputs(const Collision* col, Vec3f pos, u16 setting);
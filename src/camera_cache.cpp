@@ -0,0 +1,88 @@
+#include "camera_cache.hpp"
+
+// splitmix64 finalizer
+static u64 mix(u64 h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+u64 CameraKey::hash() const {
+  u64 h = mix(((u64)this->x << 32) | this->z);
+  h = mix(h ^ (((u64)this->y << 32) | ((u64)this->angle << 16) |
+               this->setting));
+  h = mix(h ^ (u64)(uintptr_t)this->col);
+  h = mix(h ^ this->dynaKey);
+  return h;
+}
+
+CameraCache::CameraCache(size_t maxBytes) {
+  u64 numBuckets = 1;
+  while (numBuckets * 2 * sizeof(Bucket) <= maxBytes) {
+    numBuckets *= 2;
+  }
+  this->buckets.reset(new Bucket[numBuckets]);
+  this->mask = numBuckets - 1;
+}
+
+void CameraCache::clear() {
+  for (u64 i = 0; i <= this->mask; i++) {
+    Bucket& bucket = this->buckets[i];
+    bucket.next = 0;
+    for (Entry& entry : bucket.entries) {
+      entry.used = false;
+    }
+  }
+  this->hits = 0;
+}
+
+bool CameraCache::find(const CameraKey& key, bool* stable, u16* cameraAngle) {
+  Bucket* bucket = &this->buckets[key.hash() & this->mask];
+  while (bucket->lock.test_and_set(std::memory_order_acquire)) {
+  }
+
+  bool found = false;
+  for (const Entry& entry : bucket->entries) {
+    if (entry.used && entry.key == key) {
+      *stable = entry.stable;
+      *cameraAngle = entry.cameraAngle;
+      found = true;
+      break;
+    }
+  }
+
+  bucket->lock.clear(std::memory_order_release);
+
+  if (found) {
+    this->hits++;
+  }
+  return found;
+}
+
+void CameraCache::insert(const CameraKey& key, bool stable, u16 cameraAngle) {
+  Bucket* bucket = &this->buckets[key.hash() & this->mask];
+  while (bucket->lock.test_and_set(std::memory_order_acquire)) {
+  }
+
+  Entry* replace = &bucket->entries[bucket->next];
+  for (Entry& entry : bucket->entries) {
+    if (entry.used && entry.key == key) {
+      // Another thread got here first
+      replace = nullptr;
+      break;
+    }
+  }
+
+  if (replace) {
+    replace->key = key;
+    replace->used = true;
+    replace->stable = stable;
+    replace->cameraAngle = cameraAngle;
+    bucket->next = (bucket->next + 1) % BUCKET_SIZE;
+  }
+
+  bucket->lock.clear(std::memory_order_release);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "collision.hpp"
+#include "global.hpp"
+
+// Everything that determines where the camera settles for a setup standing on
+// a floor: the camera only depends on the floor poly through whether there is
+// one, and setups in the air are never simulated. The collision is identified
+// by its address and the positions of its dynapolys (DynaCollision::key), so
+// entries stay correct when a search moves a dyna.
+struct CameraKey {
+  Collision* col;
+  u64 dynaKey;
+  u32 x;
+  u32 y;
+  u32 z;
+  u16 angle;
+  u16 setting;
+
+  bool operator==(const CameraKey& rhs) const = default;
+
+  u64 hash() const;
+};
+
+// Fixed-size hash table of settled camera angles, so that search nodes which
+// end up at the same position and angle only simulate the camera once. Safe to
+// share between search threads. Entries are only valid while the static scene
+// doesn't change. When a bucket is full, the oldest entry is replaced.
+struct CameraCache {
+  static const int BUCKET_SIZE = 4;
+
+  struct Entry {
+    CameraKey key;
+    bool used = false;
+    bool stable;
+    u16 cameraAngle;
+  };
+
+  struct Bucket {
+    std::atomic_flag lock;
+    u8 next = 0;  // Entry to replace next
+    Entry entries[BUCKET_SIZE];
+  };
+
+  std::unique_ptr<Bucket[]> buckets;
+  u64 mask;
+
+  std::atomic<unsigned long long> hits = 0;
+
+  // Allocates a cache using at most the given amount of memory.
+  CameraCache(size_t maxBytes);
+
+  // Removes all entries, so the cache can be reused for another search.
+  void clear();
+
+  // Returns true and sets the result if the key is in the cache.
+  bool find(const CameraKey& key, bool* stable, u16* cameraAngle);
+  void insert(const CameraKey& key, bool stable, u16 cameraAngle);
+};
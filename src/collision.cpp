@@ -1,12 +1,15 @@
 #include "collision.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 
 #include "global.hpp"
 #include "skin_matrix.hpp"
 #include "sys_math3d.hpp"
 
-void CollisionPoly_GetVertices(CollisionPoly* poly, Vec3s* vtxList,
+void CollisionPoly_GetVertices(CollisionPoly* poly, const Vec3s* vtxList,
                                Vec3f* dest) {
   dest[0] = vtxList[poly->v1 & 0x1FFF];
   dest[1] = vtxList[poly->v2 & 0x1FFF];
@@ -21,7 +24,7 @@ Vec3f CollisionPoly_GetNormalF(CollisionPoly* poly) {
   };
 }
 
-f32 CollisionPoly_GetMinY(CollisionPoly* poly, Vec3s* vtxList) {
+f32 CollisionPoly_GetMinY(CollisionPoly* poly, const Vec3s* vtxList) {
   Vec3f polyVerts[3];
   CollisionPoly_GetVertices(poly, vtxList, polyVerts);
 
@@ -35,53 +38,76 @@ f32 CollisionPoly_GetMinY(CollisionPoly* poly, Vec3s* vtxList) {
   return std::min(std::min(polyVerts[0].y, polyVerts[1].y), polyVerts[2].y);
 }
 
-s32 CollisionPoly_LineVsPoly(CollisionPoly* poly, Vec3s* vtxList, Vec3f posA,
-                             Vec3f posB, Vec3f* planeIntersect) {
-  f32 planeDistA = ((s16)poly->nx * posA.x + (s16)poly->ny * posA.y +
-                    (s16)poly->nz * posA.z) *
-                       COLPOLY_NORMAL_FRAC +
-                   (s16)poly->dist;
-  f32 planeDistB = ((s16)poly->nx * posB.x + (s16)poly->ny * posB.y +
-                    (s16)poly->nz * posB.z) *
-                       COLPOLY_NORMAL_FRAC +
-                   (s16)poly->dist;
-  f32 planeDistDelta = planeDistA - planeDistB;
-  if ((planeDistA >= 0.0f && planeDistB >= 0.0f) ||
-      (planeDistA < 0.0f && planeDistB < 0.0f) ||
-      (planeDistA < 0.0f && planeDistB > 0.0f) || IS_ZERO(planeDistDelta)) {
+// Computes the distances of the line's endpoints to a poly's plane, given the
+// poly's normal components before scaling and its plane distance. Returns false
+// if the line does not cross the plane from the front.
+bool CollisionPoly_LineVsPlane(f32 nx, f32 ny, f32 nz, f32 dist, Vec3f posA,
+                               Vec3f posB, f32* planeDistA,
+                               f32* planeDistDelta) {
+  *planeDistA =
+      (nx * posA.x + ny * posA.y + nz * posA.z) * COLPOLY_NORMAL_FRAC + dist;
+  f32 planeDistB =
+      (nx * posB.x + ny * posB.y + nz * posB.z) * COLPOLY_NORMAL_FRAC + dist;
+  *planeDistDelta = *planeDistA - planeDistB;
+  if ((*planeDistA >= 0.0f && planeDistB >= 0.0f) ||
+      (*planeDistA < 0.0f && planeDistB < 0.0f) ||
+      (*planeDistA < 0.0f && planeDistB > 0.0f) || IS_ZERO(*planeDistDelta)) {
     return false;
   }
+  return true;
+}
 
-  Vec3f polyVerts[3];
-  CollisionPoly_GetVertices(poly, vtxList, polyVerts);
-
-  Plane plane;
-  plane.originDist = (s16)poly->dist;
-  plane.normal = CollisionPoly_GetNormalF(poly);
-
+// Finds where the line crosses the poly's plane and checks if that point is
+// inside the poly.
+s32 CollisionPoly_LineVsPolyVerts(Vec3f* polyVerts, Plane* plane, Vec3f posA,
+                                  Vec3f posB, f32 planeDistA,
+                                  f32 planeDistDelta, Vec3f* planeIntersect) {
   Math3D_LineSplitRatio(&posA, &posB, planeDistA / planeDistDelta,
                         planeIntersect);
 
-  return (fabsf(plane.normal.x) > 0.5f &&
+  return (fabsf(plane->normal.x) > 0.5f &&
           Math3D_TriChkPointParaXDist(&polyVerts[0], &polyVerts[1],
-                                      &polyVerts[2], &plane, planeIntersect->y,
+                                      &polyVerts[2], plane, planeIntersect->y,
                                       planeIntersect->z, 1.0f)) ||
-         (fabsf(plane.normal.y) > 0.5f &&
+         (fabsf(plane->normal.y) > 0.5f &&
           Math3D_TriChkPointParaYDist(&polyVerts[0], &polyVerts[1],
-                                      &polyVerts[2], &plane, planeIntersect->z,
+                                      &polyVerts[2], plane, planeIntersect->z,
                                       planeIntersect->x, 1.0f)) ||
-         (fabsf(plane.normal.z) > 0.5f &&
+         (fabsf(plane->normal.z) > 0.5f &&
           Math3D_TriChkLineSegParaZDist(
-              &polyVerts[0], &polyVerts[1], &polyVerts[2], &plane,
+              &polyVerts[0], &polyVerts[1], &polyVerts[2], plane,
               planeIntersect->x, planeIntersect->y, 1.0f));
 }
 
-u32 SurfaceType_GetData(Collision* col, CollisionPoly* poly, s32 dataIdx) {
-  return col->header->surfaceTypeList[poly->type].data[dataIdx];
+s32 CollisionPoly_LineVsPoly(CollisionPoly* poly, const Vec3s* vtxList,
+                             Vec3f posA, Vec3f posB, Vec3f* planeIntersect) {
+  f32 planeDistA;
+  f32 planeDistDelta;
+  if (!CollisionPoly_LineVsPlane((s16)poly->nx, (s16)poly->ny, (s16)poly->nz,
+                                 (s16)poly->dist, posA, posB, &planeDistA,
+                                 &planeDistDelta)) {
+    return false;
+  }
+
+  Vec3f polyVerts[3];
+  CollisionPoly_GetVertices(poly, vtxList, polyVerts);
+
+  Plane plane;
+  plane.originDist = (s16)poly->dist;
+  plane.normal = CollisionPoly_GetNormalF(poly);
+
+  return CollisionPoly_LineVsPolyVerts(polyVerts, &plane, posA, posB,
+                                       planeDistA, planeDistDelta,
+                                       planeIntersect);
+}
+
+u32 SurfaceType_GetData(const StaticCollision* scene, CollisionPoly* poly,
+                        s32 dataIdx) {
+  return scene->header->surfaceTypeList[poly->type].data[dataIdx];
 }
 
-u32 SurfaceType_IsSoft(Collision* col, CollisionPoly* poly) {
-  return SurfaceType_GetData(col, poly, 0) >> 30 & 1;
+u32 SurfaceType_IsSoft(const StaticCollision* scene, CollisionPoly* poly) {
+  return SurfaceType_GetData(scene, poly, 0) >> 30 & 1;
 }
 
 void BgCheck_ComputeWallDisplacement(CollisionPoly* poly, f32* posX, f32* posZ,
@@ -93,27 +119,145 @@ void BgCheck_ComputeWallDisplacement(CollisionPoly* poly, f32* posX, f32* posZ,
   *posZ += displacement * normal.z;
 }
 
-bool BgCheck_CheckLineAgainstList(Collision* col,
-                                  std::vector<CollisionPoly*>* polys,
-                                  Vec3f posA, Vec3f* posB, f32* minDistSq,
+// Scratch space for grid lookups that span several cells
+static thread_local std::vector<int> sGridScratch;
+
+// Calls f with the index of each poly in a static poly list, in list order,
+// skipping the polys not found by a grid lookup. The lookup only holds while
+// valid() is true; once it is false, all remaining polys in the list are
+// checked.
+template <typename V, typename F>
+void BgCheck_ForEachStaticPoly(const std::vector<CollisionPoly*>* polys,
+                               const std::vector<int>* indices, V valid, F f) {
+  size_t next = 0;
+  if (indices) {
+    for (int i : *indices) {
+      if (!valid()) {
+        break;
+      }
+      f(i);
+      next = i + 1;
+    }
+    if (valid()) {
+      return;
+    }
+  }
+
+  for (size_t i = next; i < polys->size(); i++) {
+    f(i);
+  }
+}
+
+bool BgCheck_CheckLineAgainstList(const std::vector<CollisionPoly*>* polys,
+                                  const StaticGrid* grid,
+                                  const StaticPolyCache* cache, Vec3f posA,
+                                  Vec3f* posB, f32* minDistSq,
                                   CollisionPoly** outPoly) {
   bool result = false;
   Vec3f posIntersect;
 
-  for (CollisionPoly* poly : *polys) {
-    // TODO: sort polys by min Y
-    f32 minY = CollisionPoly_GetMinY(poly, col->vtxList);
+  // posB only moves towards posA, so the lookup holds for the whole list
+  const std::vector<int>* indices =
+      grid->find(posA.x, posA.z, posB->x, posB->z, &sGridScratch);
+  BgCheck_ForEachStaticPoly(polys, indices, [] { return true; }, [&](int i) {
+    // Each hit shortens the segment for the following polys, so this stays in
+    // list order and can only skip polys by Y one at a time
+    f32 minY = cache->lineMinY[i];
+    if (posA.y < minY && posB->y < minY) {
+      return;
+    }
+
+    f32 planeDistA;
+    f32 planeDistDelta;
+    if (!CollisionPoly_LineVsPlane(cache->rawNx[i], cache->rawNy[i],
+                                   cache->rawNz[i], cache->dist[i], posA,
+                                   *posB, &planeDistA, &planeDistDelta)) {
+      return;
+    }
+
+    Vec3f polyVerts[3] = {cache->verts[i * 3], cache->verts[i * 3 + 1],
+                          cache->verts[i * 3 + 2]};
+    Plane plane;
+    plane.originDist = cache->dist[i];
+    plane.normal = Vec3f(cache->nx[i], cache->ny[i], cache->nz[i]);
+
+    if (CollisionPoly_LineVsPolyVerts(polyVerts, &plane, posA, *posB,
+                                      planeDistA, planeDistDelta,
+                                      &posIntersect)) {
+      f32 distSq = Math3D_Vec3fDistSq(&posA, &posIntersect);
+      if (distSq < *minDistSq) {
+        *minDistSq = distSq;
+        *posB = posIntersect;
+        *outPoly = (*polys)[i];
+        result = true;
+      }
+    }
+  });
+  return result;
+}
+
+// Same as checking the floors, walls and ceilings with
+// BgCheck_CheckLineAgainstList, using the camera grid to look up all three
+// lists at once and only in the cells along the line. Every poly that the line
+// could hit is in those cells, and they are tested in the same order, so the
+// result is the same.
+static bool BgCheck_CheckLineAgainstCameraGrid(const StaticCollision* scene,
+                                               Vec3f posA, Vec3f* posB,
+                                               f32* minDistSq,
+                                               CollisionPoly** outPoly) {
+  const std::vector<int>* keys = scene->cameraGrid.findLine(
+      posA.x, posA.z, posB->x, posB->z, &sGridScratch);
+  if (!keys) {
+    bool result = false;
+    result |= BgCheck_CheckLineAgainstList(&scene->floors, &scene->floorGrid,
+                                           &scene->floorCache, posA, posB,
+                                           minDistSq, outPoly);
+    result |= BgCheck_CheckLineAgainstList(&scene->walls, &scene->wallGrid,
+                                           &scene->wallCache, posA, posB,
+                                           minDistSq, outPoly);
+    result |= BgCheck_CheckLineAgainstList(&scene->ceilings,
+                                           &scene->ceilingGrid,
+                                           &scene->ceilingCache, posA, posB,
+                                           minDistSq, outPoly);
+    return result;
+  }
+
+  const std::vector<CollisionPoly*>* lists[] = {&scene->floors, &scene->walls,
+                                                &scene->ceilings};
+  const StaticPolyCache* caches[] = {&scene->floorCache, &scene->wallCache,
+                                     &scene->ceilingCache};
+  bool result = false;
+  Vec3f posIntersect;
+  for (int key : *keys) {
+    const StaticPolyCache* cache = caches[STATIC_CAMERA_LIST(key)];
+    int i = STATIC_CAMERA_INDEX(key);
+    f32 minY = cache->lineMinY[i];
     if (posA.y < minY && posB->y < minY) {
       continue;
     }
 
-    if (CollisionPoly_LineVsPoly(poly, col->vtxList, posA, *posB,
-                                 &posIntersect)) {
+    f32 planeDistA;
+    f32 planeDistDelta;
+    if (!CollisionPoly_LineVsPlane(cache->rawNx[i], cache->rawNy[i],
+                                   cache->rawNz[i], cache->dist[i], posA,
+                                   *posB, &planeDistA, &planeDistDelta)) {
+      continue;
+    }
+
+    Vec3f polyVerts[3] = {cache->verts[i * 3], cache->verts[i * 3 + 1],
+                          cache->verts[i * 3 + 2]};
+    Plane plane;
+    plane.originDist = cache->dist[i];
+    plane.normal = Vec3f(cache->nx[i], cache->ny[i], cache->nz[i]);
+
+    if (CollisionPoly_LineVsPolyVerts(polyVerts, &plane, posA, *posB,
+                                      planeDistA, planeDistDelta,
+                                      &posIntersect)) {
       f32 distSq = Math3D_Vec3fDistSq(&posA, &posIntersect);
       if (distSq < *minDistSq) {
         *minDistSq = distSq;
         *posB = posIntersect;
-        *outPoly = poly;
+        *outPoly = (*lists[STATIC_CAMERA_LIST(key)])[i];
         result = true;
       }
     }
@@ -121,8 +265,157 @@ bool BgCheck_CheckLineAgainstList(Collision* col,
   return result;
 }
 
-bool BgCheck_CheckLineAgainstDynaList(Collision* col, Dyna* dyna,
-                                      std::vector<CollisionPoly*>* polys,
+// Batched line tests. Each line still tests the polys in list order, since a
+// hit shortens it for the polys after it, but lines that look up the same grid
+// cells share the lookup, and the checks that reject most polys are done for
+// all of those lines at once. They do the same float operations as the scalar
+// checks, so the results are identical.
+
+// The Y check of BgCheck_CheckLineAgainstList and CollisionPoly_LineVsPlane
+// for n lines stored by component in coords (all posA.x, then all posA.y, and
+// so on), without branches so that they vectorize. Sets crosses[k] for the
+// lines that pass both, and returns whether any did.
+static bool BgCheck_LinesVsPlane(const f32* coords, int n, f32 minY, f32 nx,
+                                 f32 ny, f32 nz, f32 dist, s32* crosses) {
+  const f32* ax = &coords[0];
+  const f32* ay = &coords[n];
+  const f32* az = &coords[2 * n];
+  const f32* bx = &coords[3 * n];
+  const f32* by = &coords[4 * n];
+  const f32* bz = &coords[5 * n];
+  s32 any = 0;
+  for (int k = 0; k < n; k++) {
+    f32 distA =
+        (nx * ax[k] + ny * ay[k] + nz * az[k]) * COLPOLY_NORMAL_FRAC + dist;
+    f32 distB =
+        (nx * bx[k] + ny * by[k] + nz * bz[k]) * COLPOLY_NORMAL_FRAC + dist;
+    f32 delta = distA - distB;
+    s32 below = (ay[k] < minY) & (by[k] < minY);
+    s32 misses = ((distA >= 0.0f) & (distB >= 0.0f)) |
+                 ((distA < 0.0f) & (distB < 0.0f)) |
+                 ((distA < 0.0f) & (distB > 0.0f)) | IS_ZERO(delta);
+    crosses[k] = !(below | misses);
+    any |= crosses[k];
+  }
+  return any != 0;
+}
+
+// Same as BgCheck_CheckLineAgainstList for each line from posA[j] to posB[j].
+static void BgCheck_CheckLineAgainstListBatch(
+    const std::vector<CollisionPoly*>* polys, const StaticGrid* grid,
+    const StaticPolyCache* cache, const Vec3f* posA, Vec3f* posB,
+    f32* minDistSq, CollisionPoly** outPolys, int count) {
+  struct Lane {
+    int cells[4];  // -1 if the lookup is disabled
+    int j;
+
+    bool operator<(const Lane& rhs) const {
+      return std::lexicographical_compare(this->cells, this->cells + 4,
+                                          rhs.cells, rhs.cells + 4);
+    }
+    bool sameCells(const Lane& rhs) const {
+      return std::equal(this->cells, this->cells + 4, rhs.cells);
+    }
+  };
+  static thread_local std::vector<Lane> lanes;
+  // Lines of the current group by component, and which of them cross the
+  // plane of the current poly
+  static thread_local std::vector<f32> coords;
+  static thread_local std::vector<s32> crossesVec;
+
+  lanes.clear();
+  for (int j = 0; j < count; j++) {
+    Lane lane;
+    lane.j = j;
+    if (!grid->findCells(posA[j].x, posA[j].z, posB[j].x, posB[j].z,
+                         &lane.cells[0], &lane.cells[1], &lane.cells[2],
+                         &lane.cells[3])) {
+      std::fill(lane.cells, lane.cells + 4, -1);
+    }
+    lanes.push_back(lane);
+  }
+  std::sort(lanes.begin(), lanes.end());
+
+  for (size_t begin = 0, end; begin < lanes.size(); begin = end) {
+    end = begin + 1;
+    while (end < lanes.size() && lanes[end].sameCells(lanes[begin])) {
+      end++;
+    }
+
+    int n = end - begin;
+    coords.resize(6 * n);
+    crossesVec.resize(n);
+    f32* ax = &coords[0];
+    f32* ay = &coords[n];
+    f32* az = &coords[2 * n];
+    f32* bx = &coords[3 * n];
+    f32* by = &coords[4 * n];
+    f32* bz = &coords[5 * n];
+    s32* crosses = crossesVec.data();
+    for (int k = 0; k < n; k++) {
+      int j = lanes[begin + k].j;
+      ax[k] = posA[j].x;
+      ay[k] = posA[j].y;
+      az[k] = posA[j].z;
+      bx[k] = posB[j].x;
+      by[k] = posB[j].y;
+      bz[k] = posB[j].z;
+    }
+
+    int first = lanes[begin].j;
+    const std::vector<int>* indices =
+        grid->find(posA[first].x, posA[first].z, posB[first].x,
+                   posB[first].z, &sGridScratch);
+    BgCheck_ForEachStaticPoly(polys, indices, [] { return true; }, [&](int i) {
+      f32 minY = cache->lineMinY[i];
+      f32 nx = cache->rawNx[i];
+      f32 ny = cache->rawNy[i];
+      f32 nz = cache->rawNz[i];
+      f32 dist = cache->dist[i];
+
+      if (!BgCheck_LinesVsPlane(coords.data(), n, minY, nx, ny, nz, dist,
+                                crosses)) {
+        return;
+      }
+
+      Vec3f polyVerts[3] = {cache->verts[i * 3], cache->verts[i * 3 + 1],
+                            cache->verts[i * 3 + 2]};
+      Plane plane;
+      plane.originDist = dist;
+      plane.normal = Vec3f(cache->nx[i], cache->ny[i], cache->nz[i]);
+
+      for (int k = 0; k < n; k++) {
+        if (!crosses[k]) {
+          continue;
+        }
+        int j = lanes[begin + k].j;
+        Vec3f from = posA[j];
+        f32 planeDistA;
+        f32 planeDistDelta;
+        CollisionPoly_LineVsPlane(nx, ny, nz, dist, from, posB[j], &planeDistA,
+                                  &planeDistDelta);
+        Vec3f posIntersect;
+        if (!CollisionPoly_LineVsPolyVerts(polyVerts, &plane, from, posB[j],
+                                           planeDistA, planeDistDelta,
+                                           &posIntersect)) {
+          continue;
+        }
+        f32 distSq = Math3D_Vec3fDistSq(&from, &posIntersect);
+        if (distSq < minDistSq[j]) {
+          minDistSq[j] = distSq;
+          posB[j] = posIntersect;
+          outPolys[j] = (*polys)[i];
+          bx[k] = posIntersect.x;
+          by[k] = posIntersect.y;
+          bz[k] = posIntersect.z;
+        }
+      }
+    });
+  }
+}
+
+bool BgCheck_CheckLineAgainstDynaList(const Dyna* dyna,
+                                      const std::vector<CollisionPoly*>* polys,
                                       Vec3f posA, Vec3f* posB, f32* minDistSq,
                                       CollisionPoly** outPoly) {
   bool result = false;
@@ -142,7 +435,65 @@ bool BgCheck_CheckLineAgainstDynaList(Collision* col, Dyna* dyna,
   return result;
 }
 
-bool BgCheck_CheckLineImpl(Collision* col, Vec3f posPrev, Vec3f posNext,
+// Returns false if a line can't hit any poly of the dyna. A hit is on the line
+// and within 1 unit of the poly's bounds along the two axes the poly is
+// projected on, so the line has to come that close on at least two axes. The
+// extra unit covers rounding in the intersection.
+static bool BgCheck_LineNearDyna(const Dyna* dyna, Vec3f posA, Vec3f posB) {
+  auto near = [](f32 a, f32 b, f32 min, f32 max) {
+    return std::min(a, b) <= max + 2.0f && std::max(a, b) >= min - 2.0f;
+  };
+  int axes = near(posA.x, posB.x, dyna->vtxMin.x, dyna->vtxMax.x) +
+             near(posA.y, posB.y, dyna->vtxMin.y, dyna->vtxMax.y) +
+             near(posA.z, posB.z, dyna->vtxMin.z, dyna->vtxMax.z);
+  return axes >= 2;
+}
+
+// Tests a line against the dynapolys, after the static polys.
+static bool BgCheck_CheckLineDyna(const DynaCollision* dynaCol, Vec3f posA,
+                                  Vec3f* posB, f32* minDistSq, bool checkWalls,
+                                  bool checkFloors, bool checkCeilings,
+                                  CollisionPoly** outPoly, int* outDynaId) {
+  bool result = false;
+  for (int i = 0; i < dynaCol->dynas.size(); i++) {
+    const Dyna* dyna = &dynaCol->dynas[i];
+
+    if ((posA.y < dyna->minY && posB->y < dyna->minY) ||
+        (posA.y > dyna->maxY && posB->y > dyna->maxY)) {
+      continue;
+    }
+
+    if (!BgCheck_LineNearDyna(dyna, posA, *posB)) {
+      continue;
+    }
+
+    if (checkWalls &&
+        BgCheck_CheckLineAgainstDynaList(dyna, &dyna->walls, posA, posB,
+                                         minDistSq, outPoly)) {
+      *outDynaId = i;
+      result = true;
+    }
+
+    if (checkFloors &&
+        BgCheck_CheckLineAgainstDynaList(dyna, &dyna->floors, posA, posB,
+                                         minDistSq, outPoly)) {
+      *outDynaId = i;
+      result = true;
+    }
+
+    if (checkCeilings &&
+        BgCheck_CheckLineAgainstDynaList(dyna, &dyna->ceilings, posA, posB,
+                                         minDistSq, outPoly)) {
+      *outDynaId = i;
+      result = true;
+    }
+  }
+  return result;
+}
+
+bool BgCheck_CheckLineImpl(const StaticCollision* scene,
+                           const DynaCollision* dynaCol, Vec3f posPrev,
+                           Vec3f posNext,
                            bool checkWalls, bool checkFloors,
                            bool checkCeilings, bool checkDyna,
                            Vec3f* posIntersect, CollisionPoly** outPoly,
@@ -154,184 +505,230 @@ bool BgCheck_CheckLineImpl(Collision* col, Vec3f posPrev, Vec3f posNext,
 
   // bug? For scene collision, floors are checked before walls, while for
   // dynapoly, walls are checked before floors.
-  if (checkFloors && BgCheck_CheckLineAgainstList(col, &col->floors, posA,
-                                                  &posB, &minDistSq, outPoly)) {
+  if (checkFloors &&
+      BgCheck_CheckLineAgainstList(&scene->floors, &scene->floorGrid,
+                                   &scene->floorCache, posA, &posB,
+                                   &minDistSq, outPoly)) {
     *outDynaId = -1;
     result = true;
   }
 
-  if (checkWalls && BgCheck_CheckLineAgainstList(col, &col->walls, posA, &posB,
-                                                 &minDistSq, outPoly)) {
+  if (checkWalls &&
+      BgCheck_CheckLineAgainstList(&scene->walls, &scene->wallGrid,
+                                   &scene->wallCache, posA, &posB, &minDistSq,
+                                   outPoly)) {
     *outDynaId = -1;
     result = true;
   }
 
   if (checkCeilings &&
-      BgCheck_CheckLineAgainstList(col, &col->ceilings, posA, &posB, &minDistSq,
-                                   outPoly)) {
+      BgCheck_CheckLineAgainstList(&scene->ceilings, &scene->ceilingGrid,
+                                   &scene->ceilingCache, posA, &posB,
+                                   &minDistSq, outPoly)) {
     *outDynaId = -1;
     result = true;
   }
 
-  if (checkDyna) {
-    for (int i = 0; i < col->dynas.size(); i++) {
-      Dyna* dyna = &col->dynas[i];
-
-      if ((posA.y < dyna->minY && posB.y < dyna->minY) || (posA.y > dyna->maxY && posB.y > dyna->maxY)) {
-        continue;
-      }
-
-      if (checkWalls &&
-          BgCheck_CheckLineAgainstDynaList(col, dyna, &dyna->walls, posA, &posB,
-                                           &minDistSq, outPoly)) {
-        *outDynaId = i;
-        result = true;
-      }
-
-      if (checkFloors &&
-          BgCheck_CheckLineAgainstDynaList(col, dyna, &dyna->floors, posA,
-                                           &posB, &minDistSq, outPoly)) {
-        *outDynaId = i;
-        result = true;
-      }
-
-      if (checkCeilings &&
-          BgCheck_CheckLineAgainstDynaList(col, dyna, &dyna->ceilings, posA,
-                                           &posB, &minDistSq, outPoly)) {
-        *outDynaId = i;
-        result = true;
-      }
-    }
+  if (checkDyna &&
+      BgCheck_CheckLineDyna(dynaCol, posA, &posB, &minDistSq, checkWalls,
+                            checkFloors, checkCeilings, outPoly, outDynaId)) {
+    result = true;
   }
 
   *posIntersect = posB;
   return result;
 }
 
-bool BgCheck_SphVsStaticWall(Collision* col, Vec3f pos, f32 radius, f32* x,
-                             f32* z, CollisionPoly** wallPoly) {
+// Same as BgCheck_CheckLineImpl for each line from posA[j] to posB[j], checking
+// every kind of poly and the dynapolys like camera line tests do.
+static void BgCheck_CheckLineBatch(const StaticCollision* scene,
+                                   const DynaCollision* dynaCol,
+                                   const Vec3f* posA, const Vec3f* posB,
+                                   Vec3f* posIntersect,
+                                   CollisionPoly** outPolys, int count) {
+  static thread_local std::vector<f32> minDistSq;
+
+  minDistSq.assign(count, 1.0e38f);
+  for (int j = 0; j < count; j++) {
+    posIntersect[j] = posB[j];
+  }
+
+  BgCheck_CheckLineAgainstListBatch(&scene->floors, &scene->floorGrid,
+                                    &scene->floorCache, posA, posIntersect,
+                                    minDistSq.data(), outPolys, count);
+  BgCheck_CheckLineAgainstListBatch(&scene->walls, &scene->wallGrid,
+                                    &scene->wallCache, posA, posIntersect,
+                                    minDistSq.data(), outPolys, count);
+  BgCheck_CheckLineAgainstListBatch(&scene->ceilings, &scene->ceilingGrid,
+                                    &scene->ceilingCache, posA, posIntersect,
+                                    minDistSq.data(), outPolys, count);
+
+  for (int j = 0; j < count; j++) {
+    int dynaId;
+    BgCheck_CheckLineDyna(dynaCol, posA[j], &posIntersect[j], &minDistSq[j],
+                          true, true, true, &outPolys[j], &dynaId);
+  }
+}
+
+bool BgCheck_SphVsStaticWall(const StaticCollision* scene, Vec3f pos,
+                             f32 radius, f32* x, f32* z,
+                             CollisionPoly** wallPoly) {
+  const StaticPolyCache* cache = &scene->wallCache;
   bool result = false;
   Vec3f resultPos = pos;
 
-  for (CollisionPoly* poly : col->walls) {
-    Vec3f polyVerts[3];
-    CollisionPoly_GetVertices(poly, col->vtxList, polyVerts);
-
-    // TODO: sort by min Y
-    if (pos.y < polyVerts[0].y && pos.y < polyVerts[1].y &&
-        pos.y < polyVerts[2].y) {
-      continue;
-    }
+  // A wall can only displace resultPos if it is within radius of the wall's
+  // bounding box, so the lookup holds until the displacement gets close to
+  // STATIC_GRID_OVERLAP
+  const std::vector<int>* indices =
+      scene->wallGrid.find(pos.x - radius, pos.z - radius, pos.x + radius,
+                           pos.z + radius, &sGridScratch);
+  auto valid = [&] {
+    return fabsf(resultPos.x - pos.x) <= STATIC_GRID_OVERLAP - 2.0f &&
+           fabsf(resultPos.z - pos.z) <= STATIC_GRID_OVERLAP - 2.0f;
+  };
 
-    Vec3f normal = CollisionPoly_GetNormalF(poly);
-    f32 normalXZ = sqrtf(SQ(normal.x) + SQ(normal.z));
-    f32 planeDist = Math3D_DistPlaneToPos(normal.x, normal.y, normal.z,
-                                          (s16)poly->dist, &resultPos);
-    if (fabsf(planeDist) > radius) {
-      continue;
+  // The checks that only read the cache come first. They have no side
+  // effects, so the order in which they reject a poly doesn't matter.
+  BgCheck_ForEachStaticPoly(&scene->walls, indices, valid, [&](int i) {
+    // Each push moves resultPos for the following polys, so this stays in list
+    // order
+    if (pos.y < cache->yMin[i]) {
+      return;
     }
 
-    f32 invNormalXZ = 1.0f / normalXZ;
-    f32 zDist = fabsf(normal.z) * invNormalXZ;
+    f32 zDist = cache->zDist[i];
     if (zDist < 0.4f) {
-      continue;
+      return;
     }
 
     // compute curPoly zMin/zMax
-    f32 zMin =
-        std::min(std::min(polyVerts[0].z, polyVerts[1].z), polyVerts[2].z) -
-        radius;
-    f32 zMax =
-        std::max(std::max(polyVerts[0].z, polyVerts[1].z), polyVerts[2].z) +
-        radius;
-
+    f32 zMin = cache->zMin[i] - radius;
+    f32 zMax = cache->zMax[i] + radius;
     if (resultPos.z < zMin || resultPos.z > zMax) {
-      continue;
+      return;
+    }
+
+    Vec3f normal(cache->nx[i], cache->ny[i], cache->nz[i]);
+    f32 normMagnitude = cache->normMagnitude[i];
+    f32 planeDist =
+        IS_ZERO(normMagnitude)
+            ? 0.0f
+            : Math3D_Planef(normal.x, normal.y, normal.z, cache->dist[i],
+                            &resultPos) /
+                  normMagnitude;
+    if (fabsf(planeDist) > radius) {
+      return;
+    }
+
+    // Bounds check done first by Math3D_TriChkPointParaZIntersect
+    if (IS_ZERO(normal.z) || !(cache->xMin[i] - 1.0f <= resultPos.x &&
+                               cache->xMax[i] + 1.0f >= resultPos.x &&
+                               cache->yMin[i] - 1.0f <= pos.y &&
+                               cache->yMax[i] + 1.0f >= pos.y)) {
+      return;
     }
 
+    Vec3f polyVerts[3] = {cache->verts[i * 3], cache->verts[i * 3 + 1],
+                          cache->verts[i * 3 + 2]};
     f32 intersect;
     if (Math3D_TriChkPointParaZIntersect(
             &polyVerts[0], &polyVerts[1], &polyVerts[2], normal.x, normal.y,
-            normal.z, (s16)poly->dist, resultPos.x, pos.y, &intersect)) {
+            normal.z, cache->dist[i], resultPos.x, pos.y, &intersect)) {
       if (fabsf(intersect - resultPos.z) <= radius / zDist) {
         if ((intersect - resultPos.z) * normal.z <= 4.0f) {
-          BgCheck_ComputeWallDisplacement(poly, &resultPos.x, &resultPos.z,
-                                          normal, invNormalXZ, planeDist,
-                                          radius);
+          BgCheck_ComputeWallDisplacement(
+              scene->walls[i], &resultPos.x, &resultPos.z, normal,
+              cache->invNormalXZ[i], planeDist, radius);
           result = true;
-          *wallPoly = poly;
+          *wallPoly = scene->walls[i];
         }
       }
     }
-  }
-
-  for (CollisionPoly* poly : col->walls) {
-    Vec3f polyVerts[3];
-    CollisionPoly_GetVertices(poly, col->vtxList, polyVerts);
-
-    // TODO: sort by min Y
-    if (pos.y < polyVerts[0].y && pos.y < polyVerts[1].y &&
-        pos.y < polyVerts[2].y) {
-      continue;
-    }
+  });
 
-    Vec3f normal = CollisionPoly_GetNormalF(poly);
-    f32 normalXZ = sqrtf(SQ(normal.x) + SQ(normal.z));
-    f32 planeDist = Math3D_DistPlaneToPos(normal.x, normal.y, normal.z,
-                                          (s16)poly->dist, &resultPos);
-    if (fabsf(planeDist) > radius) {
-      continue;
+  BgCheck_ForEachStaticPoly(&scene->walls, indices, valid, [&](int i) {
+    if (pos.y < cache->yMin[i]) {
+      return;
     }
 
-    f32 invNormalXZ = 1.0f / normalXZ;
-    f32 xDist = fabsf(normal.x) * invNormalXZ;
+    f32 xDist = cache->xDist[i];
     if (xDist < 0.4f) {
-      continue;
+      return;
     }
 
     // compute curPoly xMin/xMax
-    f32 xMin =
-        std::min(std::min(polyVerts[0].x, polyVerts[1].x), polyVerts[2].x) -
-        radius;
-    f32 xMax =
-        std::max(std::max(polyVerts[0].x, polyVerts[1].x), polyVerts[2].x) +
-        radius;
-
+    f32 xMin = cache->xMin[i] - radius;
+    f32 xMax = cache->xMax[i] + radius;
     if (resultPos.x < xMin || resultPos.x > xMax) {
-      continue;
+      return;
     }
 
+    Vec3f normal(cache->nx[i], cache->ny[i], cache->nz[i]);
+    f32 normMagnitude = cache->normMagnitude[i];
+    f32 planeDist =
+        IS_ZERO(normMagnitude)
+            ? 0.0f
+            : Math3D_Planef(normal.x, normal.y, normal.z, cache->dist[i],
+                            &resultPos) /
+                  normMagnitude;
+    if (fabsf(planeDist) > radius) {
+      return;
+    }
+
+    // Bounds check done first by Math3D_TriChkPointParaXIntersect
+    if (IS_ZERO(normal.x) || !(cache->yMin[i] - 1.0f <= pos.y &&
+                               cache->yMax[i] + 1.0f >= pos.y &&
+                               cache->zMin[i] - 1.0f <= resultPos.z &&
+                               cache->zMax[i] + 1.0f >= resultPos.z)) {
+      return;
+    }
+
+    Vec3f polyVerts[3] = {cache->verts[i * 3], cache->verts[i * 3 + 1],
+                          cache->verts[i * 3 + 2]};
     f32 intersect;
     if (Math3D_TriChkPointParaXIntersect(
             &polyVerts[0], &polyVerts[1], &polyVerts[2], normal.x, normal.y,
-            normal.z, (s16)poly->dist, pos.y, resultPos.z, &intersect)) {
+            normal.z, cache->dist[i], pos.y, resultPos.z, &intersect)) {
       if (fabsf(intersect - resultPos.x) <= radius / xDist) {
         if ((intersect - resultPos.x) * normal.x <= 4.0f) {
-          BgCheck_ComputeWallDisplacement(poly, &resultPos.x, &resultPos.z,
-                                          normal, invNormalXZ, planeDist,
-                                          radius);
+          BgCheck_ComputeWallDisplacement(
+              scene->walls[i], &resultPos.x, &resultPos.z, normal,
+              cache->invNormalXZ[i], planeDist, radius);
           result = true;
-          *wallPoly = poly;
+          *wallPoly = scene->walls[i];
         }
       }
     }
-  }
+  });
 
   *x = resultPos.x;
   *z = resultPos.z;
   return result;
 }
 
-bool BgCheck_SphVsDynaWall(Collision* col, Vec3f pos, f32 radius, f32* x,
-                           f32* z, CollisionPoly** wallPoly) {
+bool BgCheck_SphVsDynaWall(const DynaCollision* dynaCol, Vec3f pos,
+                           f32 radius, f32* x, f32* z,
+                           CollisionPoly** wallPoly) {
   bool result = false;
   Vec3f resultPos = pos;
 
-  for (Dyna& dyna : col->dynas) {
+  for (const Dyna& dyna : dynaCol->dynas) {
     if (pos.y < dyna.minY || pos.y > dyna.maxY) {
       continue;
     }
 
+    // Both passes need resultPos within radius of a poly's bounds on one axis
+    // and within 1 unit on the other. If no poly passes, resultPos doesn't
+    // move, so checking it once before the dyna's polys is enough.
+    f32 margin = std::max(radius, 1.0f);
+    if (resultPos.x < dyna.vtxMin.x - margin ||
+        resultPos.x > dyna.vtxMax.x + margin ||
+        resultPos.z < dyna.vtxMin.z - margin ||
+        resultPos.z > dyna.vtxMax.z + margin) {
+      continue;
+    }
+
     for (CollisionPoly* poly : dyna.walls) {
       Vec3f polyVerts[3];
       CollisionPoly_GetVertices(poly, dyna.vertices.data(), polyVerts);
@@ -442,7 +839,8 @@ bool BgCheck_SphVsDynaWall(Collision* col, Vec3f pos, f32 radius, f32* x,
   return result;
 }
 
-bool BgCheck_EntitySphVsWall(Collision* col, Vec3f posPrev, Vec3f posNext,
+bool BgCheck_EntitySphVsWall(const StaticCollision* scene,
+                             const DynaCollision* dynaCol, Vec3f posPrev, Vec3f posNext,
                              Vec3f* posResult, f32 checkHeight, f32 radius, CollisionPoly** wallPoly) {
   CollisionPoly* poly;
   int dynaId;
@@ -460,7 +858,7 @@ bool BgCheck_EntitySphVsWall(Collision* col, Vec3f posPrev, Vec3f posNext,
     if (checkHeight + dy < 5.0f) {
       //! @bug checkHeight is not applied to posPrev/posNext
       Vec3f posIntersect;
-      if (BgCheck_CheckLineImpl(col, posPrev, posNext, true, true, false, true,
+      if (BgCheck_CheckLineImpl(scene, dynaCol, posPrev, posNext, true, true, false, true,
                                 &posIntersect, &poly, &dynaId)) {
         result = true;
         *wallPoly = poly;
@@ -486,7 +884,7 @@ bool BgCheck_EntitySphVsWall(Collision* col, Vec3f posPrev, Vec3f posNext,
       checkLinePrev.y = checkLineNext.y;
 
       Vec3f posIntersect;
-      if (BgCheck_CheckLineImpl(col, checkLinePrev, checkLineNext, true,
+      if (BgCheck_CheckLineImpl(scene, dynaCol, checkLinePrev, checkLineNext, true,
                                 checkFloors, false, true, &posIntersect, &poly,
                                 &dynaId)) {
         *wallPoly = poly;
@@ -510,7 +908,7 @@ bool BgCheck_EntitySphVsWall(Collision* col, Vec3f posPrev, Vec3f posNext,
   sphCenter.y += checkHeight;
 
   bool dynaResult = false;
-  if (BgCheck_SphVsDynaWall(col, sphCenter, radius, &posResult->x,
+  if (BgCheck_SphVsDynaWall(dynaCol, sphCenter, radius, &posResult->x,
                             &posResult->z, &poly)) {
     result = true;
     dynaResult = true;
@@ -519,7 +917,7 @@ bool BgCheck_EntitySphVsWall(Collision* col, Vec3f posPrev, Vec3f posNext,
     sphCenter.y += checkHeight;
   }
 
-  if (BgCheck_SphVsStaticWall(col, sphCenter, radius, &posResult->x,
+  if (BgCheck_SphVsStaticWall(scene, sphCenter, radius, &posResult->x,
                               &posResult->z, &poly)) {
     dynaId = -1;
     result = true;
@@ -528,7 +926,7 @@ bool BgCheck_EntitySphVsWall(Collision* col, Vec3f posPrev, Vec3f posNext,
 
   if (dynaResult || dynaId != -1) {
     Vec3f posIntersect;
-    if (BgCheck_CheckLineImpl(col, posPrev, *posResult, true, false, false,
+    if (BgCheck_CheckLineImpl(scene, dynaCol, posPrev, *posResult, true, false, false,
                               false, &posIntersect, &poly, &dynaId)) {
       Vec3f normal = CollisionPoly_GetNormalF(poly);
       f32 nXZDist = sqrtf(SQ(normal.x) + SQ(normal.z));
@@ -547,61 +945,106 @@ bool BgCheck_EntitySphVsWall(Collision* col, Vec3f posPrev, Vec3f posNext,
   return result;
 }
 
-bool BgCheck_RaycastDownStaticList(Collision* col,
-                                   std::vector<CollisionPoly*>* polys,
-                                   Vec3f pos, f32* floorHeight,
+// Intersects a vertical ray through pos with poly i of a static poly list.
+static bool BgCheck_RaycastDownStaticPoly(const StaticPolyCache* cache, int i,
+                                          Vec3f pos, f32* yIntersect) {
+  f32 ny = cache->ny[i];
+  if (ny < 0) {
+    return false;
+  }
+
+  // Bounds check done first by Math3D_TriChkPointParaYIntersectInsideTri
+  if (!(cache->zMin[i] - 1.0f <= pos.z && cache->zMax[i] + 1.0f >= pos.z &&
+        cache->xMin[i] - 1.0f <= pos.x && cache->xMax[i] + 1.0f >= pos.x)) {
+    return false;
+  }
+
+  Vec3f polyVerts[3] = {cache->verts[i * 3], cache->verts[i * 3 + 1],
+                        cache->verts[i * 3 + 2]};
+  return (bool)Math3D_TriChkPointParaYIntersectInsideTri(
+      &polyVerts[0], &polyVerts[1], &polyVerts[2], cache->nx[i], ny,
+      cache->nz[i], cache->dist[i], pos.z, pos.x, yIntersect, 1.0f);
+}
+
+bool BgCheck_RaycastDownStaticList(const std::vector<CollisionPoly*>* polys,
+                                   const StaticGrid* grid,
+                                   const StaticPolyCache* cache, Vec3f pos,
+                                   f32* floorHeight,
                                    CollisionPoly** floorPoly) {
   bool result = false;
   f32 yIntersect;
-  for (CollisionPoly* poly : *polys) {
-    Vec3f polyVerts[3];
-
-    CollisionPoly_GetVertices(poly, col->vtxList, polyVerts);
-    Vec3f normal = CollisionPoly_GetNormalF(poly);
-    if (normal.y < 0) {
-      continue;
-    }
+  auto intersect = [&](int i) {
+    return BgCheck_RaycastDownStaticPoly(cache, i, pos, &yIntersect);
+  };
 
-    if (Math3D_TriChkPointParaYIntersectInsideTri(
-            &polyVerts[0], &polyVerts[1], &polyVerts[2], normal.x, normal.y,
-            normal.z, (s16)poly->dist, pos.z, pos.x, &yIntersect, 1.0f)) {
-      // if poly is closer to pos without going over
-      if (yIntersect < pos.y && *floorHeight < yIntersect) {
+  // The result is the highest hit below pos, and the first in list order if
+  // several are equally high. Going from the top, we can stop at the first
+  // poly that can't reach the current best.
+  const std::vector<int>* byY = grid->findByY(pos.x, pos.z);
+  if (byY != NULL) {
+    int bestIndex = -1;
+    for (int i : *byY) {
+      if (cache->raycastYMax[i] < *floorHeight) {
+        break;
+      }
+      if (cache->raycastYMin[i] >= pos.y || !intersect(i)) {
+        continue;
+      }
+      if (yIntersect < pos.y &&
+          (*floorHeight < yIntersect ||
+           (*floorHeight == yIntersect && i < bestIndex))) {
         result = true;
+        bestIndex = i;
         *floorHeight = yIntersect;
-        *floorPoly = poly;
+        *floorPoly = (*polys)[i];
       }
     }
+    return result;
   }
+
+  const std::vector<int>* indices =
+      grid->find(pos.x, pos.z, pos.x, pos.z, &sGridScratch);
+  BgCheck_ForEachStaticPoly(polys, indices, [] { return true; }, [&](int i) {
+    // if poly is closer to pos without going over
+    if (intersect(i) && yIntersect < pos.y && *floorHeight < yIntersect) {
+      result = true;
+      *floorHeight = yIntersect;
+      *floorPoly = (*polys)[i];
+    }
+  });
   return result;
 }
 
-bool BgCheck_RaycastDownStatic(Collision* col, Vec3f pos, f32* floorHeight,
-                               CollisionPoly** floorPoly, int* dynaId) {
+bool BgCheck_RaycastDownStatic(const StaticCollision* scene, Vec3f pos,
+                               f32* floorHeight, CollisionPoly** floorPoly,
+                               int* dynaId) {
   bool result = false;
   *floorHeight = BGCHECK_Y_MIN;
 
-  if (BgCheck_RaycastDownStaticList(col, &col->floors, pos, floorHeight,
+  if (BgCheck_RaycastDownStaticList(&scene->floors, &scene->floorGrid,
+                                    &scene->floorCache, pos, floorHeight,
                                     floorPoly)) {
     *dynaId = -1;
     result = true;
   }
 
-  if (BgCheck_RaycastDownStaticList(col, &col->walls, pos, floorHeight,
+  if (BgCheck_RaycastDownStaticList(&scene->walls, &scene->wallGrid,
+                                    &scene->wallCache, pos, floorHeight,
                                     floorPoly)) {
     *dynaId = -1;
     result = true;
   }
 
-  if (*floorHeight != BGCHECK_Y_MIN && SurfaceType_IsSoft(col, *floorPoly)) {
+  if (*floorHeight != BGCHECK_Y_MIN && SurfaceType_IsSoft(scene, *floorPoly)) {
     *floorHeight -= 1.0f;
   }
 
   return result;
 }
 
-bool BgCheck_RaycastDownDynaList(Collision* col, Dyna* dyna,
-                                 std::vector<CollisionPoly*>* polys, Vec3f pos,
+bool BgCheck_RaycastDownDynaList(const Dyna* dyna,
+                                 const std::vector<CollisionPoly*>* polys,
+                                 Vec3f pos,
                                  f32* floorHeight, CollisionPoly** floorPoly) {
   bool result = false;
   for (CollisionPoly* poly : *polys) {
@@ -627,12 +1070,19 @@ bool BgCheck_RaycastDownDynaList(Collision* col, Dyna* dyna,
   return result;
 }
 
-bool BgCheck_RaycastDownDyna(Collision* col, Vec3f pos, f32* floorHeight,
-                             CollisionPoly** floorPoly, int* dynaId) {
+bool BgCheck_RaycastDownDyna(const DynaCollision* dynaCol, Vec3f pos,
+                             f32* floorHeight, CollisionPoly** floorPoly,
+                             int* dynaId) {
   bool result = false;
-  for (int i = 0; i < col->dynas.size(); i++) {
-    Dyna* dyna = &col->dynas[i];
-    if (BgCheck_RaycastDownDynaList(col, dyna, &dyna->floors, pos, floorHeight,
+  for (int i = 0; i < dynaCol->dynas.size(); i++) {
+    const Dyna* dyna = &dynaCol->dynas[i];
+    // Bounds check done first by Math3D_TriChkPointParaYIntersectDist
+    if (pos.x < dyna->vtxMin.x - 1.0f || pos.x > dyna->vtxMax.x + 1.0f ||
+        pos.z < dyna->vtxMin.z - 1.0f || pos.z > dyna->vtxMax.z + 1.0f) {
+      continue;
+    }
+
+    if (BgCheck_RaycastDownDynaList(dyna, &dyna->floors, pos, floorHeight,
                                     floorPoly)) {
       *dynaId = i;
       result = true;
@@ -642,7 +1092,7 @@ bool BgCheck_RaycastDownDyna(Collision* col, Vec3f pos, f32* floorHeight,
     // only checked if there is no floor detected i.e. we're over the void. This
     // is pretty rare but maybe it will be needed someday.
 
-    // if (BgCheck_RaycastDownDynaList(col, dyna, &dyna->walls, pos, floorHeight,
+    // if (BgCheck_RaycastDownDynaList(dyna, &dyna->walls, pos, floorHeight,
     //                                 floorPoly)) {
     //   *dynaId = i;
     //   result = true;
@@ -651,35 +1101,557 @@ bool BgCheck_RaycastDownDyna(Collision* col, Vec3f pos, f32* floorHeight,
   return result;
 }
 
-bool BgCheck_RaycastDownImpl(Collision* col, Vec3f pos, f32* floorHeight,
-                             CollisionPoly** floorPoly, int* dynaId) {
+bool BgCheck_RaycastDownImpl(const StaticCollision* scene,
+                             const DynaCollision* dynaCol, Vec3f pos,
+                             f32* floorHeight, CollisionPoly** floorPoly,
+                             int* dynaId) {
   bool result = false;
   *floorHeight = BGCHECK_Y_MIN;
 
-  if (BgCheck_RaycastDownStatic(col, pos, floorHeight, floorPoly, dynaId)) {
+  if (BgCheck_RaycastDownStatic(scene, pos, floorHeight, floorPoly, dynaId)) {
     result = true;
   }
 
-  if (BgCheck_RaycastDownDyna(col, pos, floorHeight, floorPoly, dynaId)) {
+  if (BgCheck_RaycastDownDyna(dynaCol, pos, floorHeight, floorPoly, dynaId)) {
     result = true;
   }
 
   return result;
 }
 
-Collision::Collision(CollisionHeader* header, PlayerAge age) {
+// Batched downward raycasts. Each poly is loaded once and tested against every
+// lane that could hit it, instead of walking the poly lists again for each
+// position. A raycast keeps the highest hit (the first one in list order on
+// ties), so the order of the tests doesn't change the results.
+
+// Finds the floors below pos[lanes[k]] in a static poly list, updating the
+// results of the lanes that hit something. Lanes found in the same grid cell
+// scan its polys together.
+static void BgCheck_RaycastDownStaticListBatch(
+    const std::vector<CollisionPoly*>* polys, const StaticGrid* grid,
+    const StaticPolyCache* cache, const Vec3f* pos, int count,
+    CollisionCheckResult* results) {
+  struct Lane {
+    const std::vector<int>* byY;
+    const std::vector<int>* indices;
+    int j;
+    int bestIndex;
+  };
+  static thread_local std::vector<Lane> lanes;
+  static thread_local std::vector<Lane*> active;
+
+  lanes.clear();
+  for (int j = 0; j < count; j++) {
+    const std::vector<int>* byY = grid->findByY(pos[j].x, pos[j].z);
+    // A lookup at a single point never uses the scratch space
+    const std::vector<int>* indices =
+        byY ? NULL
+            : grid->find(pos[j].x, pos[j].z, pos[j].x, pos[j].z,
+                         &sGridScratch);
+    lanes.push_back({byY, indices, j, -1});
+  }
+  // Batches are small and usually already grouped, so an insertion sort is
+  // fastest
+  for (size_t k = 1; k < lanes.size(); k++) {
+    Lane lane = lanes[k];
+    size_t m = k;
+    while (m > 0 && (std::less<>()(lane.byY, lanes[m - 1].byY) ||
+                     (lane.byY == lanes[m - 1].byY &&
+                      std::less<>()(lane.indices, lanes[m - 1].indices)))) {
+      lanes[m] = lanes[m - 1];
+      m--;
+    }
+    lanes[m] = lane;
+  }
+
+  f32 yIntersect;
+  auto update = [&](Lane* lane, int i) {
+    CollisionCheckResult* result = &results[lane->j];
+    result->floorHeight = yIntersect;
+    result->floorPoly = (*polys)[i];
+    result->dynaId = -1;
+    lane->bestIndex = i;
+  };
+
+  for (size_t begin = 0, end; begin < lanes.size(); begin = end) {
+    end = begin + 1;
+    while (end < lanes.size() && lanes[end].byY == lanes[begin].byY &&
+           lanes[end].indices == lanes[begin].indices) {
+      end++;
+    }
+    active.clear();
+    for (size_t k = begin; k < end; k++) {
+      active.push_back(&lanes[k]);
+    }
+
+    if (lanes[begin].byY != NULL) {
+      // Like BgCheck_RaycastDownStaticList, but a lane is dropped (instead of
+      // stopping) once the polys can't reach its current best
+      for (int i : *lanes[begin].byY) {
+        f32 yMax = cache->raycastYMax[i];
+        f32 yMin = cache->raycastYMin[i];
+        size_t numActive = 0;
+        for (Lane* lane : active) {
+          Vec3f p = pos[lane->j];
+          f32 floorHeight = results[lane->j].floorHeight;
+          if (yMax < floorHeight) {
+            continue;
+          }
+          active[numActive++] = lane;
+          if (yMin >= p.y ||
+              !BgCheck_RaycastDownStaticPoly(cache, i, p, &yIntersect)) {
+            continue;
+          }
+          if (yIntersect < p.y &&
+              (floorHeight < yIntersect ||
+               (floorHeight == yIntersect && i < lane->bestIndex))) {
+            update(lane, i);
+          }
+        }
+        active.resize(numActive);
+        if (active.empty()) {
+          break;
+        }
+      }
+      continue;
+    }
+
+    BgCheck_ForEachStaticPoly(
+        polys, lanes[begin].indices, [] { return true; }, [&](int i) {
+          for (Lane* lane : active) {
+            Vec3f p = pos[lane->j];
+            if (BgCheck_RaycastDownStaticPoly(cache, i, p, &yIntersect) &&
+                yIntersect < p.y &&
+                results[lane->j].floorHeight < yIntersect) {
+              update(lane, i);
+            }
+          }
+        });
+  }
+}
+
+static void BgCheck_RaycastDownDynaBatch(const DynaCollision* dynaCol,
+                                         const Vec3f* pos, int count,
+                                         CollisionCheckResult* results) {
+  static thread_local std::vector<int> lanes;
+
+  for (int i = 0; i < dynaCol->dynas.size(); i++) {
+    const Dyna* dyna = &dynaCol->dynas[i];
+    lanes.clear();
+    for (int j = 0; j < count; j++) {
+      if (!(pos[j].x < dyna->vtxMin.x - 1.0f ||
+            pos[j].x > dyna->vtxMax.x + 1.0f ||
+            pos[j].z < dyna->vtxMin.z - 1.0f ||
+            pos[j].z > dyna->vtxMax.z + 1.0f)) {
+        lanes.push_back(j);
+      }
+    }
+    if (lanes.empty()) {
+      continue;
+    }
+
+    for (CollisionPoly* poly : dyna->floors) {
+      Vec3f polyVerts[3];
+      CollisionPoly_GetVertices(poly, dyna->vertices.data(), polyVerts);
+      Vec3f normal = CollisionPoly_GetNormalF(poly);
+
+      // BGCHECK_RAYCAST_DOWN_CHECK_GROUND_ONLY
+      if (normal.y < 0.0f) {
+        continue;
+      }
+
+      for (int j : lanes) {
+        CollisionCheckResult* result = &results[j];
+        f32 yIntersect;
+        if (Math3D_TriChkPointParaYIntersectDist(
+                &polyVerts[0], &polyVerts[1], &polyVerts[2], normal.x,
+                normal.y, normal.z, (s16)poly->dist, pos[j].z, pos[j].x,
+                &yIntersect, 1.0f) &&
+            yIntersect < pos[j].y && result->floorHeight < yIntersect) {
+          result->floorHeight = yIntersect;
+          result->floorPoly = poly;
+          result->dynaId = i;
+        }
+      }
+    }
+  }
+}
+
+// Same as BgCheck_RaycastDownImpl for each position. Sets the floorHeight of
+// each result, and its floorPoly and dynaId if there is a floor.
+static void BgCheck_RaycastDownBatch(const StaticCollision* scene,
+                                     const DynaCollision* dynaCol,
+                                     const Vec3f* pos, int count,
+                                     CollisionCheckResult* results) {
+  for (int j = 0; j < count; j++) {
+    results[j].floorHeight = BGCHECK_Y_MIN;
+  }
+
+  BgCheck_RaycastDownStaticListBatch(&scene->floors, &scene->floorGrid,
+                                     &scene->floorCache, pos, count, results);
+  BgCheck_RaycastDownStaticListBatch(&scene->walls, &scene->wallGrid,
+                                     &scene->wallCache, pos, count, results);
+  for (int j = 0; j < count; j++) {
+    if (results[j].floorHeight != BGCHECK_Y_MIN &&
+        SurfaceType_IsSoft(scene, results[j].floorPoly)) {
+      results[j].floorHeight -= 1.0f;
+    }
+  }
+
+  BgCheck_RaycastDownDynaBatch(dynaCol, pos, count, results);
+}
+
+Dyna::Dyna(const Dyna& other) { *this = other; }
+
+Dyna& Dyna::operator=(const Dyna& other) {
+  this->header = other.header;
+  this->minY = other.minY;
+  this->maxY = other.maxY;
+  this->vtxMin = other.vtxMin;
+  this->vtxMax = other.vtxMax;
+  this->vertices = other.vertices;
+  this->polys = other.polys;
+  this->key = other.key;
+  this->mtx = other.mtx;
+  this->srcVertices = other.srcVertices;
+  this->srcPolys = other.srcPolys;
+  this->normals = other.normals;
+
+  auto rebase = [&](const std::vector<CollisionPoly*>& from,
+                    std::vector<CollisionPoly*>* to) {
+    to->clear();
+    for (CollisionPoly* poly : from) {
+      to->push_back(this->polys.data() + (poly - other.polys.data()));
+    }
+  };
+  rebase(other.walls, &this->walls);
+  rebase(other.floors, &this->floors);
+  rebase(other.ceilings, &this->ceilings);
+  return *this;
+}
+
+// Returns the cell containing v along one axis, clamped to the grid, or -1 if v
+// is NaN.
+static int StaticGrid_GetCell(f32 v, f32 min, f32 cellSize, int numCells) {
+  f32 cell = (v - min) / cellSize;
+  if (std::isnan(cell)) {
+    return -1;
+  }
+  if (cell < 0.0f) {
+    return 0;
+  }
+  if (cell >= numCells) {
+    return numCells - 1;
+  }
+  return (int)cell;
+}
+
+void StaticGrid::init(CollisionHeader* header, f32 cellSize, bool sortByY) {
+  this->cells.clear();
+  this->cellsByY.clear();
+  if (cellSize <= 0.0f) {
+    this->cellSize = 0.0f;
+    this->numX = 0;
+    this->numZ = 0;
+    return;
+  }
+
+  f32 xSize = header->maxBound.x - header->minBound.x;
+  f32 zSize = header->maxBound.z - header->minBound.z;
+  // Limit the number of cells for very large scenes
+  while (xSize / cellSize > 256 || zSize / cellSize > 256) {
+    cellSize *= 2;
+  }
+
+  this->xMin = header->minBound.x;
+  this->zMin = header->minBound.z;
+  this->cellSize = cellSize;
+  this->numX = std::max((int)(xSize / cellSize) + 1, 1);
+  this->numZ = std::max((int)(zSize / cellSize) + 1, 1);
+  this->cells.resize(this->numX * this->numZ);
+  if (sortByY) {
+    this->cellsByY.resize(this->numX * this->numZ);
+  }
+}
+
+void StaticGrid::add(int index, const StaticPolyCache* cache, int key) {
+  if (this->cellSize == 0.0f) {
+    return;
+  }
+
+  f32 polyXMin = cache->xMin[index] - STATIC_GRID_OVERLAP;
+  f32 polyXMax = cache->xMax[index] + STATIC_GRID_OVERLAP;
+  f32 polyZMin = cache->zMin[index] - STATIC_GRID_OVERLAP;
+  f32 polyZMax = cache->zMax[index] + STATIC_GRID_OVERLAP;
+
+  int cx0 =
+      StaticGrid_GetCell(polyXMin, this->xMin, this->cellSize, this->numX);
+  int cx1 =
+      StaticGrid_GetCell(polyXMax, this->xMin, this->cellSize, this->numX);
+  int cz0 =
+      StaticGrid_GetCell(polyZMin, this->zMin, this->cellSize, this->numZ);
+  int cz1 =
+      StaticGrid_GetCell(polyZMax, this->zMin, this->cellSize, this->numZ);
+  f32 yMax = cache->raycastYMax[index];
+  if (key < 0) {
+    key = index;
+  }
+  for (int cz = cz0; cz <= cz1; cz++) {
+    for (int cx = cx0; cx <= cx1; cx++) {
+      // Polys are usually added in key order, so this is normally the end
+      std::vector<int>& cell = this->cells[cz * this->numX + cx];
+      cell.insert(std::upper_bound(cell.begin(), cell.end(), key), key);
+      if (!this->cellsByY.empty()) {
+        // After any polys with the same raycastYMax, to keep list order
+        std::vector<int>& cellByY = this->cellsByY[cz * this->numX + cx];
+        auto it = std::upper_bound(
+            cellByY.begin(), cellByY.end(), yMax,
+            [&](f32 y, int i) { return y > cache->raycastYMax[i]; });
+        cellByY.insert(it, index);
+      }
+    }
+  }
+}
+
+bool StaticGrid::findCells(f32 x0, f32 z0, f32 x1, f32 z1, int* cx0, int* cz0,
+                           int* cx1, int* cz1) const {
+  if (this->cellSize == 0.0f) {
+    return false;
+  }
+
+  *cx0 = StaticGrid_GetCell(x0, this->xMin, this->cellSize, this->numX);
+  *cx1 = StaticGrid_GetCell(x1, this->xMin, this->cellSize, this->numX);
+  *cz0 = StaticGrid_GetCell(z0, this->zMin, this->cellSize, this->numZ);
+  *cz1 = StaticGrid_GetCell(z1, this->zMin, this->cellSize, this->numZ);
+  if (*cx0 < 0 || *cx1 < 0 || *cz0 < 0 || *cz1 < 0) {
+    return false;
+  }
+  if (*cx0 > *cx1) {
+    std::swap(*cx0, *cx1);
+  }
+  if (*cz0 > *cz1) {
+    std::swap(*cz0, *cz1);
+  }
+  return true;
+}
+
+const std::vector<int>* StaticGrid::find(f32 x0, f32 z0, f32 x1, f32 z1,
+                                         std::vector<int>* scratch) const {
+  int cx0, cz0, cx1, cz1;
+  if (!findCells(x0, z0, x1, z1, &cx0, &cz0, &cx1, &cz1)) {
+    return NULL;
+  }
+
+  if (cx0 == cx1 && cz0 == cz1) {
+    return &this->cells[cz0 * this->numX + cx0];
+  }
+
+  scratch->clear();
+  for (int cz = cz0; cz <= cz1; cz++) {
+    for (int cx = cx0; cx <= cx1; cx++) {
+      const std::vector<int>& cell = this->cells[cz * this->numX + cx];
+      scratch->insert(scratch->end(), cell.begin(), cell.end());
+    }
+  }
+  std::sort(scratch->begin(), scratch->end());
+  scratch->erase(std::unique(scratch->begin(), scratch->end()), scratch->end());
+  return scratch;
+}
+
+// Merges the given cells into scratch in increasing order without duplicates.
+static const std::vector<int>* StaticGrid_MergeCells(
+    const std::vector<const std::vector<int>*>& cells,
+    std::vector<int>* scratch) {
+  scratch->clear();
+  // Neighbouring cells share most of their polys, so merging the few cells
+  // along a line directly is faster than sorting all of their entries
+  if (cells.size() > 8) {
+    for (const std::vector<int>* cell : cells) {
+      scratch->insert(scratch->end(), cell->begin(), cell->end());
+    }
+    std::sort(scratch->begin(), scratch->end());
+    scratch->erase(std::unique(scratch->begin(), scratch->end()),
+                   scratch->end());
+    return scratch;
+  }
+
+  const int* pos[8];
+  const int* end[8];
+  int n = 0;
+  for (const std::vector<int>* cell : cells) {
+    if (!cell->empty()) {
+      pos[n] = cell->data();
+      end[n] = cell->data() + cell->size();
+      n++;
+    }
+  }
+  while (n > 0) {
+    int next = *pos[0];
+    for (int k = 1; k < n; k++) {
+      next = std::min(next, *pos[k]);
+    }
+    scratch->push_back(next);
+    for (int k = 0; k < n;) {
+      if (*pos[k] == next && ++pos[k] == end[k]) {
+        n--;
+        pos[k] = pos[n];
+        end[k] = end[n];
+      } else {
+        k++;
+      }
+    }
+  }
+  return scratch;
+}
+
+// Cells along the line found by StaticGrid::findLine
+static thread_local std::vector<const std::vector<int>*> sFoundCells;
+
+const std::vector<int>* StaticGrid::findLine(f32 x0, f32 z0, f32 x1, f32 z1,
+                                             std::vector<int>* scratch) const {
+  int cx0, cz0, cx1, cz1;
+  if (!findCells(x0, z0, x1, z1, &cx0, &cz0, &cx1, &cz1)) {
+    return NULL;
+  }
+
+  if (cx0 == cx1 && cz0 == cz1) {
+    return &this->cells[cz0 * this->numX + cx0];
+  }
+
+  // Walk the columns of cells between the ends of the line, looking up the
+  // cells of the part of the line in each column. Columns are widened by a
+  // unit for rounding, and the cells are clamped to the line's bounding box,
+  // so every cell that find() would return for a point on the line is
+  // included.
+  f32 lineXMin = std::min(x0, x1);
+  f32 lineXMax = std::max(x0, x1);
+  f32 dx = x1 - x0;
+  f32 dz = z1 - z0;
+  sFoundCells.clear();
+  for (int cx = cx0; cx <= cx1; cx++) {
+    int czMin = cz0;
+    int czMax = cz1;
+    if (cx0 != cx1) {
+      // The first and last columns also hold any part outside the grid
+      f32 colXMin = cx == cx0 ? lineXMin
+                              : this->xMin + cx * this->cellSize - 1.0f;
+      f32 colXMax = cx == cx1 ? lineXMax
+                              : this->xMin + (cx + 1) * this->cellSize + 1.0f;
+      f32 t0 = (std::max(colXMin, lineXMin) - x0) / dx;
+      f32 t1 = (std::min(colXMax, lineXMax) - x0) / dx;
+      t0 = std::clamp(t0, 0.0f, 1.0f);
+      t1 = std::clamp(t1, 0.0f, 1.0f);
+      f32 za = z0 + dz * t0;
+      f32 zb = z0 + dz * t1;
+      czMin = std::max(czMin, StaticGrid_GetCell(std::min(za, zb) - 1.0f,
+                                                 this->zMin, this->cellSize,
+                                                 this->numZ));
+      czMax = std::min(czMax, StaticGrid_GetCell(std::max(za, zb) + 1.0f,
+                                                 this->zMin, this->cellSize,
+                                                 this->numZ));
+    }
+    for (int cz = czMin; cz <= czMax; cz++) {
+      const std::vector<int>* cell = &this->cells[cz * this->numX + cx];
+      if (!cell->empty()) {
+        sFoundCells.push_back(cell);
+      }
+    }
+  }
+
+  if (sFoundCells.size() == 1) {
+    return sFoundCells[0];
+  }
+  return StaticGrid_MergeCells(sFoundCells, scratch);
+}
+
+const std::vector<int>* StaticGrid::findByY(f32 x, f32 z) const {
+  if (this->cellsByY.empty()) {
+    return NULL;
+  }
+
+  int cx = StaticGrid_GetCell(x, this->xMin, this->cellSize, this->numX);
+  int cz = StaticGrid_GetCell(z, this->zMin, this->cellSize, this->numZ);
+  if (cx < 0 || cz < 0) {
+    return NULL;
+  }
+  return &this->cellsByY[cz * this->numX + cx];
+}
+
+void StaticPolyCache::add(CollisionPoly* poly, const Vec3s* vtxList) {
+  Vec3f polyVerts[3];
+  CollisionPoly_GetVertices(poly, vtxList, polyVerts);
+  this->xMin.push_back(
+      std::min(std::min(polyVerts[0].x, polyVerts[1].x), polyVerts[2].x));
+  this->xMax.push_back(
+      std::max(std::max(polyVerts[0].x, polyVerts[1].x), polyVerts[2].x));
+  this->yMin.push_back(
+      std::min(std::min(polyVerts[0].y, polyVerts[1].y), polyVerts[2].y));
+  this->yMax.push_back(
+      std::max(std::max(polyVerts[0].y, polyVerts[1].y), polyVerts[2].y));
+  this->zMin.push_back(
+      std::min(std::min(polyVerts[0].z, polyVerts[1].z), polyVerts[2].z));
+  this->zMax.push_back(
+      std::max(std::max(polyVerts[0].z, polyVerts[1].z), polyVerts[2].z));
+  this->lineMinY.push_back(CollisionPoly_GetMinY(poly, vtxList));
+
+  Vec3f normal = CollisionPoly_GetNormalF(poly);
+  this->nx.push_back(normal.x);
+  this->ny.push_back(normal.y);
+  this->nz.push_back(normal.z);
+  this->rawNx.push_back((s16)poly->nx);
+  this->rawNy.push_back((s16)poly->ny);
+  this->rawNz.push_back((s16)poly->nz);
+  this->dist.push_back((s16)poly->dist);
+
+  // As computed by BgCheck_SphVsStaticWall and Math3D_DistPlaneToPos
+  f32 normalXZ = sqrtf(SQ(normal.x) + SQ(normal.z));
+  f32 invNormalXZ = 1.0f / normalXZ;
+  this->normMagnitude.push_back(
+      sqrtf(SQ(normal.x) + SQ(normal.y) + SQ(normal.z)));
+  this->invNormalXZ.push_back(invNormalXZ);
+  this->xDist.push_back(fabsf(normal.x) * invNormalXZ);
+  this->zDist.push_back(fabsf(normal.z) * invNormalXZ);
+
+  this->verts.insert(this->verts.end(), polyVerts, polyVerts + 3);
+
+  // yIntersect is linear in x and z, so over the box checked by
+  // Math3D_TriChkPointParaYImpl it is bounded by its values at the corners.
+  // Floors have ny > 0.5, so the rounding error is far below the margin.
+  f32 yMin = -std::numeric_limits<f32>::infinity();
+  f32 yMax = std::numeric_limits<f32>::infinity();
+  if (normal.y > 0.5f) {
+    f64 lo = std::numeric_limits<f64>::infinity();
+    f64 hi = -std::numeric_limits<f64>::infinity();
+    for (f64 x : {this->xMin.back() - 1.0, this->xMax.back() + 1.0}) {
+      for (f64 z : {this->zMin.back() - 1.0, this->zMax.back() + 1.0}) {
+        f64 y = (-normal.x * x - normal.z * z - this->dist.back()) / normal.y;
+        lo = std::min(lo, y);
+        hi = std::max(hi, y);
+      }
+    }
+    yMin = lo - 1.0;
+    yMax = hi + 1.0;
+  }
+  this->raycastYMin.push_back(yMin);
+  this->raycastYMax.push_back(yMax);
+}
+
+StaticCollision::StaticCollision(CollisionHeader* header)
+    : StaticCollision(header, STATIC_GRID_CELL_SIZE) {}
+
+StaticCollision::StaticCollision(CollisionHeader* header, f32 gridCellSize) {
   this->header = header;
-  this->age = age;
   this->vtxList = header->vertices;
   this->polyList = header->polys;
+  setGridCellSize(gridCellSize);
 }
 
-Collision::Collision(CollisionHeader* header, PlayerAge age, Vec3f min,
-                     Vec3f max) {
+StaticCollision::StaticCollision(CollisionHeader* header, Vec3f min,
+                                 Vec3f max) {
   this->header = header;
-  this->age = age;
   this->vtxList = header->vertices;
   this->polyList = header->polys;
+  setGridCellSize(STATIC_GRID_CELL_SIZE);
 
   // TODO: what order?
   for (int polyId = 0; polyId < header->numPolys; polyId++) {
@@ -699,7 +1671,7 @@ Collision::Collision(CollisionHeader* header, PlayerAge age, Vec3f min,
   }
 }
 
-void printPoly(CollisionPoly* poly, Vec3s* vtxList, int index) {
+void printPoly(CollisionPoly* poly, const Vec3s* vtxList, int index) {
   Vec3f v[3];
   CollisionPoly_GetVertices(poly, vtxList, v);
   Vec3f normal = CollisionPoly_GetNormalF(poly);
@@ -714,25 +1686,38 @@ void printPoly(CollisionPoly* poly, Vec3s* vtxList, int index) {
       actualDist);
 }
 
-void Collision::printPolys() {
+Collision::Collision(CollisionHeader* header, PlayerAge age)
+    : Collision(std::make_shared<StaticCollision>(header), age) {}
+
+Collision::Collision(CollisionHeader* header, PlayerAge age, Vec3f min,
+                     Vec3f max)
+    : Collision(std::make_shared<StaticCollision>(header, min, max), age) {}
+
+Collision::Collision(std::shared_ptr<StaticCollision> scene, PlayerAge age) {
+  this->scene = std::move(scene);
+  this->age = age;
+}
+
+void Collision::printPolys() const {
+  const StaticCollision* scene = this->scene.get();
   printf("scene collision:\n");
   printf("  walls:\n");
-  for (CollisionPoly* poly : this->walls) {
-    printPoly(poly, this->vtxList, poly - this->polyList);
+  for (CollisionPoly* poly : scene->walls) {
+    printPoly(poly, scene->vtxList, poly - scene->polyList);
   }
 
   printf("  floors:\n");
-  for (CollisionPoly* poly : this->floors) {
-    printPoly(poly, this->vtxList, poly - this->polyList);
+  for (CollisionPoly* poly : scene->floors) {
+    printPoly(poly, scene->vtxList, poly - scene->polyList);
   }
 
   printf("  ceilings:\n");
-  for (CollisionPoly* poly : this->ceilings) {
-    printPoly(poly, this->vtxList, poly - this->polyList);
+  for (CollisionPoly* poly : scene->ceilings) {
+    printPoly(poly, scene->vtxList, poly - scene->polyList);
   }
 
-  for (int i = 0; i < this->dynas.size(); i++) {
-    Dyna* dyna = &this->dynas[i];
+  for (int i = 0; i < this->dyna.dynas.size(); i++) {
+    const Dyna* dyna = &this->dyna.dynas[i];
     printf("dyna %d:\n", i);
     printf("  walls:\n");
     for (CollisionPoly* poly : dyna->walls) {
@@ -751,47 +1736,185 @@ void Collision::printPolys() {
   }
 }
 
-void Collision::addPoly(int polyIndex) {
+void StaticCollision::addPoly(int polyIndex) {
   CollisionPoly* poly = &this->polyList[polyIndex];
 
   if ((s16)poly->ny > (s16)(0.5f * SHT_MAX)) {
+    int index = this->floors.size();
+    this->floorCache.add(poly, this->vtxList);
+    this->floorGrid.add(index, &this->floorCache);
+    this->cameraGrid.add(index, &this->floorCache,
+                         STATIC_CAMERA_KEY(STATIC_CAMERA_FLOORS, index));
     this->floors.push_back(poly);
   } else if ((s16)poly->ny < (s16)(-0.8f * SHT_MAX)) {
+    int index = this->ceilings.size();
+    this->ceilingCache.add(poly, this->vtxList);
+    this->ceilingGrid.add(index, &this->ceilingCache);
+    this->cameraGrid.add(index, &this->ceilingCache,
+                         STATIC_CAMERA_KEY(STATIC_CAMERA_CEILINGS, index));
     this->ceilings.push_back(poly);
   } else {
+    int index = this->walls.size();
+    this->wallCache.add(poly, this->vtxList);
+    this->wallGrid.add(index, &this->wallCache);
+    this->cameraGrid.add(index, &this->wallCache,
+                         STATIC_CAMERA_KEY(STATIC_CAMERA_WALLS, index));
     this->walls.push_back(poly);
   }
 }
 
+void StaticCollision::setGridCellSize(f32 cellSize) {
+  // Only floor raycasts can stop early. The other queries depend on the order
+  // of the hits.
+  this->wallGrid.init(this->header, cellSize, false);
+  this->floorGrid.init(this->header, cellSize, true);
+  this->ceilingGrid.init(this->header, cellSize, false);
+  this->cameraGrid.init(this->header, cellSize, false);
+  for (int i = 0; i < this->walls.size(); i++) {
+    this->wallGrid.add(i, &this->wallCache);
+  }
+  for (int i = 0; i < this->floors.size(); i++) {
+    this->floorGrid.add(i, &this->floorCache);
+  }
+  for (int i = 0; i < this->ceilings.size(); i++) {
+    this->ceilingGrid.add(i, &this->ceilingCache);
+  }
+  // In key order
+  for (int i = 0; i < this->floors.size(); i++) {
+    this->cameraGrid.add(i, &this->floorCache,
+                         STATIC_CAMERA_KEY(STATIC_CAMERA_FLOORS, i));
+  }
+  for (int i = 0; i < this->walls.size(); i++) {
+    this->cameraGrid.add(i, &this->wallCache,
+                         STATIC_CAMERA_KEY(STATIC_CAMERA_WALLS, i));
+  }
+  for (int i = 0; i < this->ceilings.size(); i++) {
+    this->cameraGrid.add(i, &this->ceilingCache,
+                         STATIC_CAMERA_KEY(STATIC_CAMERA_CEILINGS, i));
+  }
+}
+
+void Collision::addPoly(int polyIndex) {
+  if (this->scene.use_count() > 1) {
+    this->scene = std::make_shared<StaticCollision>(*this->scene);
+  }
+  this->scene->addPoly(polyIndex);
+}
+
+void Collision::setGridCellSize(f32 cellSize) {
+  if (this->scene.use_count() > 1) {
+    this->scene = std::make_shared<StaticCollision>(*this->scene);
+  }
+  this->scene->setGridCellSize(cellSize);
+}
+
 int Collision::addDynapoly(CollisionHeader* header, Vec3f scale, Vec3s rot,
-                            Vec3f pos) {
+                           Vec3f pos) {
+  return this->dyna.addDynapoly(header, scale, rot, pos);
+}
+
+void Collision::updateDynapoly(int dynaId, CollisionHeader* header,
+                               Vec3f scale, Vec3s rot, Vec3f pos) {
+  this->dyna.updateDynapoly(dynaId, header, scale, rot, pos);
+}
+
+int DynaCollision::addDynapoly(CollisionHeader* header, Vec3f scale, Vec3s rot,
+                               Vec3f pos) {
   this->dynas.push_back(Dyna());
+  this->keyframes.emplace_back(DYNA_KEYFRAME_SLOTS);
   int dynaId = this->dynas.size() - 1;
   updateDynapoly(dynaId, header, scale, rot, pos);
   return dynaId;
 }
 
-void Collision::updateDynapoly(int dynaId, CollisionHeader* header, Vec3f scale, Vec3s rot,
-                            Vec3f pos) {
+// splitmix64 finalizer
+static u64 Dyna_Mix(u64 h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+// Hashes the inputs of a dyna transform. The header's vertices are included
+// since some setups move them between updates.
+static u64 Dyna_Key(CollisionHeader* header, MtxF* mtx) {
+  u64 h = Dyna_Mix((uintptr_t)header);
+  u32 words[16];
+  memcpy(words, mtx, sizeof(words));
+  for (int i = 0; i < 16; i += 2) {
+    h = Dyna_Mix(h ^ (((u64)words[i] << 32) | words[i + 1]));
+  }
+  for (int i = 0; i < header->numVertices; i++) {
+    Vec3s v = header->vertices[i];
+    h = Dyna_Mix(h ^ ((u64)(u16)v.x | ((u64)(u16)v.y << 16) |
+                      ((u64)(u16)v.z << 32)));
+  }
+  return h;
+}
+
+// Returns true if the dyna was transformed from the same inputs.
+static bool Dyna_Matches(const Dyna* dyna, CollisionHeader* header,
+                         MtxF* mtx) {
+  return dyna->header == header &&
+         dyna->srcVertices.size() == header->numVertices &&
+         dyna->srcPolys.size() == header->numPolys &&
+         memcmp(&dyna->mtx, mtx, sizeof(MtxF)) == 0 &&
+         memcmp(dyna->srcVertices.data(), header->vertices,
+                header->numVertices * sizeof(Vec3s)) == 0 &&
+         memcmp(dyna->srcPolys.data(), header->polys,
+                header->numPolys * sizeof(CollisionPoly)) == 0;
+}
+
+static thread_local std::vector<Vec3s> sPrevVertices;
+
+void DynaCollision::updateDynapoly(int dynaId, CollisionHeader* header,
+                                   Vec3f scale, Vec3s rot, Vec3f pos) {
   Dyna* dyna = &this->dynas[dynaId];
+
+  MtxF mtx;
+  SkinMatrix_SetTranslateRotateYXZScale(&mtx, scale.x, scale.y, scale.z, rot.x,
+                                        rot.y, rot.z, pos.x, pos.y, pos.z);
+
+  u64 key = Dyna_Key(header, &mtx);
+  if (dyna->key == key && Dyna_Matches(dyna, header, &mtx)) {
+    return;
+  }
+  Dyna* keyframe = &this->keyframes[dynaId][key & (DYNA_KEYFRAME_SLOTS - 1)];
+  if (keyframe->key == key && Dyna_Matches(keyframe, header, &mtx)) {
+    *dyna = *keyframe;
+    return;
+  }
+
+  // A poly's normal only depends on the offsets between its rounded vertices,
+  // so it can be kept if those and the source poly are unchanged. This is
+  // usually the case when only the translation changes.
+  bool reuse = dyna->header == header &&
+               dyna->srcPolys.size() == header->numPolys &&
+               dyna->vertices.size() == header->numVertices;
+  if (reuse) {
+    sPrevVertices.swap(dyna->vertices);
+  }
+
   dyna->header = header;
+  dyna->key = key;
+  dyna->mtx = mtx;
 
   dyna->vertices.clear();
   dyna->vertices.reserve(header->numVertices);
 
-  dyna->polys.clear();
-  dyna->polys.reserve(header->numPolys);
+  dyna->polys.resize(header->numPolys);
+  dyna->normals.resize(header->numPolys);
 
   dyna->floors.clear();
   dyna->walls.clear();
   dyna->ceilings.clear();
 
-  MtxF mtx;
-  SkinMatrix_SetTranslateRotateYXZScale(&mtx, scale.x, scale.y, scale.z, rot.x,
-                                        rot.y, rot.z, pos.x, pos.y, pos.z);
-
   dyna->minY = 1.0e38f;
   dyna->maxY = -1.0e38f;
+  dyna->vtxMin = Vec3f(1.0e38f, 1.0e38f, 1.0e38f);
+  dyna->vtxMax = Vec3f(-1.0e38f, -1.0e38f, -1.0e38f);
 
   for (int i = 0; i < header->numVertices; i++) {
     Vec3f vtx = Vec3f(header->vertices[i]);
@@ -802,24 +1925,46 @@ void Collision::updateDynapoly(int dynaId, CollisionHeader* header, Vec3f scale,
     dyna->maxY = std::max(dyna->maxY, vtxT.y);
 
     dyna->vertices.push_back(vtxT.toVec3s());
+    Vec3f rounded = Vec3f(dyna->vertices.back());
+    dyna->vtxMin.x = std::min(dyna->vtxMin.x, rounded.x);
+    dyna->vtxMin.y = std::min(dyna->vtxMin.y, rounded.y);
+    dyna->vtxMin.z = std::min(dyna->vtxMin.z, rounded.z);
+    dyna->vtxMax.x = std::max(dyna->vtxMax.x, rounded.x);
+    dyna->vtxMax.y = std::max(dyna->vtxMax.y, rounded.y);
+    dyna->vtxMax.z = std::max(dyna->vtxMax.z, rounded.z);
   }
 
   for (int i = 0; i < header->numPolys; i++) {
-    dyna->polys.push_back(header->polys[i]);
-    CollisionPoly* poly = &dyna->polys.back();
-
+    CollisionPoly* poly = &dyna->polys[i];
     Vec3f polyVerts[3];
-    CollisionPoly_GetVertices(poly, dyna->vertices.data(), polyVerts);
+    CollisionPoly_GetVertices(&header->polys[i], dyna->vertices.data(),
+                              polyVerts);
+
+    bool same = false;
+    if (reuse && memcmp(&dyna->srcPolys[i], &header->polys[i],
+                        sizeof(CollisionPoly)) == 0) {
+      Vec3f prevVerts[3];
+      CollisionPoly_GetVertices(&header->polys[i], sPrevVertices.data(),
+                                prevVerts);
+      same = polyVerts[1] - polyVerts[0] == prevVerts[1] - prevVerts[0] &&
+             polyVerts[2] - polyVerts[0] == prevVerts[2] - prevVerts[0];
+    }
 
     Vec3f normal;
-    Math3D_SurfaceNorm(&polyVerts[0], &polyVerts[1], &polyVerts[2], &normal);
-    f32 normMagnitude = Math3D_Vec3fMagnitude(&normal);
-
-    if (!IS_ZERO(normMagnitude)) {
-      normal = normal * (1.0f / normMagnitude);
-      poly->nx = (s16)(normal.x * SHT_MAX);
-      poly->ny = (s16)(normal.y * SHT_MAX);
-      poly->nz = (s16)(normal.z * SHT_MAX);
+    if (same) {
+      normal = dyna->normals[i];
+    } else {
+      *poly = header->polys[i];
+      Math3D_SurfaceNorm(&polyVerts[0], &polyVerts[1], &polyVerts[2], &normal);
+      f32 normMagnitude = Math3D_Vec3fMagnitude(&normal);
+
+      if (!IS_ZERO(normMagnitude)) {
+        normal = normal * (1.0f / normMagnitude);
+        poly->nx = (s16)(normal.x * SHT_MAX);
+        poly->ny = (s16)(normal.y * SHT_MAX);
+        poly->nz = (s16)(normal.z * SHT_MAX);
+      }
+      dyna->normals[i] = normal;
     }
 
     poly->dist = -DOTXYZ(normal, polyVerts[0]);
@@ -834,18 +1979,32 @@ void Collision::updateDynapoly(int dynaId, CollisionHeader* header, Vec3f scale,
   std::reverse(dyna->floors.begin(), dyna->floors.end());
   std::reverse(dyna->ceilings.begin(), dyna->ceilings.end());
   std::reverse(dyna->walls.begin(), dyna->walls.end());
+
+  dyna->srcVertices.assign(header->vertices,
+                           header->vertices + header->numVertices);
+  dyna->srcPolys.assign(header->polys, header->polys + header->numPolys);
+
+  *keyframe = *dyna;
+}
+
+u64 DynaCollision::key() const {
+  u64 h = Dyna_Mix(this->dynas.size());
+  for (const Dyna& dyna : this->dynas) {
+    h = Dyna_Mix(h ^ dyna.key);
+  }
+  return h;
 }
 
 Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos, f32 wallCheckHeight, f32 wallRadius,
                            CollisionPoly** wallPoly, CollisionPoly** floorPoly,
-                           int* dynaId, f32* floorHeight) {
+                           int* dynaId, f32* floorHeight) const {
   *wallPoly = NULL;
   *floorPoly = NULL;
   *floorHeight = -32000.0f;
 
   // Check walls
   Vec3f wallResult;
-  if (BgCheck_EntitySphVsWall(this, prevPos, intendedPos, &wallResult, wallCheckHeight, wallRadius,
+  if (BgCheck_EntitySphVsWall(this->scene.get(), &this->dyna, prevPos, intendedPos, &wallResult, wallCheckHeight, wallRadius,
                               wallPoly)) {
     intendedPos = wallResult;
   }
@@ -853,7 +2012,7 @@ Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos, f32 wallCheckHeight
   // Check floors
   Vec3f checkPos = intendedPos;
   checkPos.y = prevPos.y + 50.0f;
-  if (BgCheck_RaycastDownImpl(this, checkPos, floorHeight, floorPoly, dynaId)) {
+  if (BgCheck_RaycastDownImpl(this->scene.get(), &this->dyna, checkPos, floorHeight, floorPoly, dynaId)) {
     f32 floorHeightDiff = *floorHeight - intendedPos.y;
     if (floorHeightDiff >= 0.0f) {  // actor is on or below the ground
       intendedPos.y = *floorHeight;
@@ -867,14 +2026,14 @@ Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos, f32 wallCheckHeight
 
 Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos,
                            CollisionPoly** wallPoly, CollisionPoly** floorPoly,
-                           int* dynaId, f32* floorHeight) {
+                           int* dynaId, f32* floorHeight) const {
   f32 checkHeight = 26.0f;
   f32 radius = this->age == PLAYER_AGE_CHILD ? 14.0f : 18.0f;
   return runChecks(prevPos, intendedPos, checkHeight, radius, wallPoly, floorPoly,
                    dynaId, floorHeight);
 }
 
-Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos, f32 wallCheckRadius, f32 wallCheckHeight) {
+Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos, f32 wallCheckRadius, f32 wallCheckHeight) const {
   CollisionPoly* wallPoly;
   CollisionPoly* floorPoly;
   int dynaId;
@@ -883,7 +2042,7 @@ Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos, f32 wallCheckRadius
                    &floorHeight);
 }
 
-Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos) {
+Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos) const {
   CollisionPoly* wallPoly;
   CollisionPoly* floorPoly;
   int dynaId;
@@ -892,15 +2051,74 @@ Vec3f Collision::runChecks(Vec3f prevPos, Vec3f intendedPos) {
                    &floorHeight);
 }
 
-Vec3f Collision::findFloor(Vec3f pos, CollisionPoly** outPoly, int* dynaId) {
+void Collision::runChecks(const CollisionCheck* checks,
+                          CollisionCheckResult* results, int count) const {
+  static thread_local std::vector<Vec3f> checkPos;
+  checkPos.resize(count);
+
+  // Wall checks move each position in turn, so they are run one at a time
+  for (int j = 0; j < count; j++) {
+    const CollisionCheck* check = &checks[j];
+    CollisionCheckResult* result = &results[j];
+    result->pos = check->intendedPos;
+    result->wallPoly = NULL;
+    result->floorPoly = NULL;
+    result->dynaId = -1;
+
+    Vec3f wallResult;
+    if (BgCheck_EntitySphVsWall(this->scene.get(), &this->dyna, check->prevPos,
+                                check->intendedPos, &wallResult,
+                                check->wallCheckHeight, check->wallCheckRadius,
+                                &result->wallPoly)) {
+      result->pos = wallResult;
+    }
+
+    checkPos[j] = result->pos;
+    checkPos[j].y = check->prevPos.y + 50.0f;
+  }
+
+  BgCheck_RaycastDownBatch(this->scene.get(), &this->dyna, checkPos.data(),
+                           count, results);
+
+  for (int j = 0; j < count; j++) {
+    CollisionCheckResult* result = &results[j];
+    if (result->floorPoly != NULL) {
+      f32 floorHeightDiff = result->floorHeight - result->pos.y;
+      if (floorHeightDiff >= 0.0f) {
+        result->pos.y = result->floorHeight;
+      }
+    }
+  }
+}
+
+void Collision::findFloors(const Vec3f* positions,
+                           CollisionCheckResult* results, int count) const {
+  for (int j = 0; j < count; j++) {
+    results[j].wallPoly = NULL;
+    results[j].floorPoly = NULL;
+    results[j].dynaId = -1;
+  }
+
+  BgCheck_RaycastDownBatch(this->scene.get(), &this->dyna, positions, count,
+                           results);
+
+  for (int j = 0; j < count; j++) {
+    results[j].pos =
+        Vec3f(positions[j].x, results[j].floorHeight, positions[j].z);
+  }
+}
+
+Vec3f Collision::findFloor(Vec3f pos, CollisionPoly** outPoly,
+                           int* dynaId) const {
   f32 floorHeight;
   *outPoly = NULL;
   *dynaId = -1;
-  BgCheck_RaycastDownImpl(this, pos, &floorHeight, outPoly, dynaId);
+  BgCheck_RaycastDownImpl(this->scene.get(), &this->dyna, pos, &floorHeight,
+                          outPoly, dynaId);
   return Vec3f(pos.x, floorHeight, pos.z);
 }
 
-Vec3f Collision::findFloor(Vec3f pos) {
+Vec3f Collision::findFloor(Vec3f pos) const {
   CollisionPoly* poly;
   int dynaId;
   return findFloor(pos, &poly, &dynaId);
@@ -908,37 +2126,52 @@ Vec3f Collision::findFloor(Vec3f pos) {
 
 Vec3f Collision::entityLineTest(Vec3f pos, Vec3f target, bool checkWalls,
                                 bool checkFloors, bool checkCeilings,
-                                CollisionPoly** outPoly) {
+                                CollisionPoly** outPoly) const {
   *outPoly = NULL;
   int dynaId;
-  BgCheck_CheckLineImpl(this, pos, target, checkWalls, checkFloors,
-                        checkCeilings, true, &target, outPoly, &dynaId);
+  BgCheck_CheckLineImpl(this->scene.get(), &this->dyna, pos, target, checkWalls,
+                        checkFloors, checkCeilings, true, &target, outPoly,
+                        &dynaId);
   return target;
 }
 
 Vec3f Collision::cameraLineTest(Vec3f pos, Vec3f target,
-                                CollisionPoly** outPoly) {
+                                CollisionPoly** outPoly) const {
   *outPoly = NULL;
+  f32 minDistSq = 1.0e38f;
   int dynaId;
-  BgCheck_CheckLineImpl(this, pos, target, true, true, true, true, &target,
-                        outPoly, &dynaId);
+  BgCheck_CheckLineAgainstCameraGrid(this->scene.get(), pos, &target,
+                                     &minDistSq, outPoly);
+  BgCheck_CheckLineDyna(&this->dyna, pos, &target, &minDistSq, true, true,
+                        true, outPoly, &dynaId);
   return target;
 }
 
-f32 Collision::cameraFindFloor(Vec3f pos, CollisionPoly** outPoly) {
+void Collision::cameraLineTests(const Vec3f* pos, const Vec3f* targets,
+                                Vec3f* results, CollisionPoly** outPolys,
+                                int count) const {
+  for (int j = 0; j < count; j++) {
+    outPolys[j] = NULL;
+  }
+  BgCheck_CheckLineBatch(this->scene.get(), &this->dyna, pos, targets, results,
+                         outPolys, count);
+}
+
+f32 Collision::cameraFindFloor(Vec3f pos, CollisionPoly** outPoly) const {
   *outPoly = NULL;
   f32 floorHeight;
   int dynaId;
-  BgCheck_RaycastDownImpl(this, pos, &floorHeight, outPoly, &dynaId);
+  BgCheck_RaycastDownImpl(this->scene.get(), &this->dyna, pos, &floorHeight,
+                          outPoly, &dynaId);
   return floorHeight;
 }
 
-u16 Collision::getCameraSetting(CollisionPoly* poly, int dynaId) {
+u16 Collision::getCameraSetting(CollisionPoly* poly, int dynaId) const {
   CollisionHeader* header;
   if (dynaId == -1) {
-    header = this->header;
+    header = this->scene->header;
   } else {
-    header = this->dynas[dynaId].header;
+    header = this->dyna.dynas[dynaId].header;
   }
 
   int bgCamIndex = header->surfaceTypeList[poly->type].data[0] & 0xFF;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "global.hpp"
@@ -58,7 +59,7 @@ struct CollisionHeader {
   WaterBox* waterBoxes;
 };
 
-void CollisionPoly_GetVertices(CollisionPoly* poly, Vec3s* vtxList,
+void CollisionPoly_GetVertices(CollisionPoly* poly, const Vec3s* vtxList,
                                Vec3f* dest);
 Vec3f CollisionPoly_GetNormalF(CollisionPoly* poly);
 
@@ -66,36 +67,220 @@ struct Dyna {
   CollisionHeader* header;
   f32 minY;
   f32 maxY;
+  // Bounds of the vertices after rounding, which the poly checks use. Queries
+  // skip the whole dyna if they can't get close enough to these.
+  Vec3f vtxMin;
+  Vec3f vtxMax;
   std::vector<Vec3s> vertices;
   std::vector<CollisionPoly> polys;
   std::vector<CollisionPoly*> walls;
   std::vector<CollisionPoly*> floors;
   std::vector<CollisionPoly*> ceilings;
+  // Inputs of the transform that produced this state, so that updates can tell
+  // when it can be reused
+  u64 key;
+  MtxF mtx;
+  std::vector<Vec3s> srcVertices;
+  std::vector<CollisionPoly> srcPolys;
+  // Unrounded normal of each poly, reused while the poly's shape is unchanged
+  std::vector<Vec3f> normals;
+
+  Dyna() = default;
+  // Copies point the poly lists into their own polys
+  Dyna(const Dyna& other);
+  Dyna& operator=(const Dyna& other);
+  Dyna(Dyna&& other) = default;
+  Dyna& operator=(Dyna&& other) = default;
 };
 
-// Simulates z_bgcheck.c for a subset of collision polygons.
-struct Collision {
+// Default cell size of the static poly grids
+#define STATIC_GRID_CELL_SIZE 128.0f
+// Polys are added to every cell within this distance of their XZ bounding box,
+// like BGCHECK_SUBDIV_OVERLAP in the game. The triangle checks only accept
+// points within 1 unit of the bounding box, so this leaves a wide margin.
+#define STATIC_GRID_OVERLAP 50.0f
+
+// Precomputed data for the polys in a static poly list, stored as separate
+// arrays so that queries can reject most polys by reading only the fields they
+// need instead of the poly and its vertices. Each value is computed the same
+// way the queries computed it from the poly, so results are unchanged.
+struct StaticPolyCache {
+  // Vertex bounds
+  std::vector<f32> xMin;
+  std::vector<f32> xMax;
+  std::vector<f32> yMin;
+  std::vector<f32> yMax;
+  std::vector<f32> zMin;
+  std::vector<f32> zMax;
+  // CollisionPoly_GetMinY, which differs from yMin for some polys
+  std::vector<f32> lineMinY;
+  // Normal from CollisionPoly_GetNormalF
+  std::vector<f32> nx;
+  std::vector<f32> ny;
+  std::vector<f32> nz;
+  // Normal components before scaling, as used by line tests
+  std::vector<f32> rawNx;
+  std::vector<f32> rawNy;
+  std::vector<f32> rawNz;
+  std::vector<f32> dist;
+  // Terms of the wall checks
+  std::vector<f32> normMagnitude;
+  std::vector<f32> invNormalXZ;
+  std::vector<f32> xDist;
+  std::vector<f32> zDist;
+  // Vertices, 3 per poly
+  std::vector<Vec3f> verts;
+  // Bounds of the yIntersect of a vertical ray through the vertex bounds, with
+  // a margin for rounding. Infinite for polys steeper than floors.
+  std::vector<f32> raycastYMin;
+  std::vector<f32> raycastYMax;
+
+  void add(CollisionPoly* poly, const Vec3s* vtxList);
+};
+
+// Uniform XZ grid over the scene bounds holding the indices of the polys in one
+// of the static poly lists. Queries only test the polys in the cells they
+// overlap, in list order, so results are the same as scanning the whole list.
+struct StaticGrid {
+  f32 xMin = 0.0f;
+  f32 zMin = 0.0f;
+  f32 cellSize = 0.0f;  // 0 if disabled
+  int numX = 0;
+  int numZ = 0;
+  // Poly indices in increasing order for each cell
+  std::vector<std::vector<int>> cells;
+  // The same indices ordered by decreasing raycastYMax, if sorted by Y
+  std::vector<std::vector<int>> cellsByY;
+
+  void init(CollisionHeader* header, f32 cellSize, bool sortByY);
+  // Adds the poly with the given index in cache. The cells hold key instead of
+  // the index if it is given, and stay in increasing order.
+  void add(int index, const StaticPolyCache* cache, int key = -1);
+  // Returns the indices of the polys in the cells overlapping the given box, in
+  // increasing order, or NULL if the grid is disabled. The result may point to
+  // scratch.
+  const std::vector<int>* find(f32 xMin, f32 zMin, f32 xMax, f32 zMax,
+                               std::vector<int>* scratch) const;
+  // Sets the range of cells that find() looks up for the given box. Returns
+  // false if find() would return NULL.
+  bool findCells(f32 xMin, f32 zMin, f32 xMax, f32 zMax, int* cx0, int* cz0,
+                 int* cx1, int* cz1) const;
+  // Same as find() for the line from (x0, z0) to (x1, z1), but only looks up
+  // the cells that the line passes through instead of its whole bounding box.
+  const std::vector<int>* findLine(f32 x0, f32 z0, f32 x1, f32 z1,
+                                   std::vector<int>* scratch) const;
+  // Returns the indices of the polys in the cell containing the given point,
+  // by decreasing raycastYMax, or NULL if the grid is disabled or not sorted
+  // by Y.
+  const std::vector<int>* findByY(f32 x, f32 z) const;
+};
+
+// Keys of StaticCollision::cameraGrid. Floors are checked before walls, then
+// ceilings.
+#define STATIC_CAMERA_FLOORS 0
+#define STATIC_CAMERA_WALLS 1
+#define STATIC_CAMERA_CEILINGS 2
+#define STATIC_CAMERA_KEY(list, index) ((list) << 24 | (index))
+#define STATIC_CAMERA_LIST(key) ((key) >> 24)
+#define STATIC_CAMERA_INDEX(key) ((key) & 0xFFFFFF)
+
+// Static scene collision polygons. This is only modified while it is being
+// built, so a single instance can be shared by any number of threads.
+struct StaticCollision {
   std::vector<CollisionPoly*> walls;
   std::vector<CollisionPoly*> floors;
   std::vector<CollisionPoly*> ceilings;
 
+  StaticGrid wallGrid;
+  StaticGrid floorGrid;
+  StaticGrid ceilingGrid;
+  // All three lists for camera line tests, which check each of them. Holds
+  // STATIC_CAMERA_KEY values, so a lookup returns the polys in the order the
+  // lists are checked.
+  StaticGrid cameraGrid;
+
+  StaticPolyCache wallCache;
+  StaticPolyCache floorCache;
+  StaticPolyCache ceilingCache;
+
   CollisionHeader* header;
-  PlayerAge age;
   Vec3s* vtxList;
   CollisionPoly* polyList;
 
+  // Empty collision
+  StaticCollision(CollisionHeader* header);
+  // Empty collision with grids of the given cell size, or none if it is 0
+  StaticCollision(CollisionHeader* header, f32 gridCellSize);
+  // Adds all triangles with a vertex within the given bounds
+  StaticCollision(CollisionHeader* header, Vec3f min, Vec3f max);
+
+  // Add a poly
+  void addPoly(int polyIndex);
+  // Rebuilds the grids with the given cell size, or disables them if it is 0
+  void setGridCellSize(f32 cellSize);
+};
+
+// Number of recent states kept for each dyna. Must be a power of 2.
+#define DYNA_KEYFRAME_SLOTS 256
+
+// Dynapolys at their current positions. Unlike the static scene this is
+// modified during a search, so each thread needs its own copy.
+struct DynaCollision {
   std::vector<Dyna> dynas;
+  // Recent states of each dyna, indexed by the hash of their transform inputs,
+  // for searches that keep moving a dyna between the same few places. A new
+  // state replaces the one in its slot.
+  std::vector<std::vector<Dyna>> keyframes;
+
+  int addDynapoly(CollisionHeader* header, Vec3f scale, Vec3s rot, Vec3f pos);
+  void updateDynapoly(int dynaId, CollisionHeader* header, Vec3f scale, Vec3s rot, Vec3f pos);
+  // Hash of the transform inputs of every dyna, which changes whenever any of
+  // them moves
+  u64 key() const;
+};
+
+// Input of a batched runChecks
+struct CollisionCheck {
+  Vec3f prevPos;
+  Vec3f intendedPos;
+  f32 wallCheckHeight;
+  f32 wallCheckRadius;
+};
+
+// Output of a batched runChecks or findFloors. floorPoly is NULL and dynaId is
+// -1 if there is no floor.
+struct CollisionCheckResult {
+  Vec3f pos;
+  CollisionPoly* wallPoly;
+  CollisionPoly* floorPoly;
+  int dynaId;
+  f32 floorHeight;
+};
+
+// Simulates z_bgcheck.c for a subset of collision polygons. Queries only read
+// the static scene and the dynapolys. Copying a Collision shares the static
+// scene and copies only the dynapolys, so threads that move dynapolys can each
+// use a copy.
+struct Collision {
+  std::shared_ptr<StaticCollision> scene;
+  DynaCollision dyna;
+  PlayerAge age;
 
   // Empty collision
   Collision(CollisionHeader* header, PlayerAge age);
   // Adds all triangles with a vertex within the given bounds
   Collision(CollisionHeader* header, PlayerAge age, Vec3f min, Vec3f max);
+  // Uses an existing static scene, e.g. one loaded once for all threads
+  Collision(std::shared_ptr<StaticCollision> scene, PlayerAge age);
 
   // Prints collision polygons
-  void printPolys();
+  void printPolys() const;
 
-  // Add a poly
+  // Add a poly. If the static scene is shared with other Collisions, this
+  // copies it first.
   void addPoly(int polyIndex);
+  // Rebuilds the static poly grids, copying the scene first if it is shared
+  void setGridCellSize(f32 cellSize);
 
   int addDynapoly(CollisionHeader* header, Vec3f scale, Vec3s rot, Vec3f pos);
   void updateDynapoly(int dynaId, CollisionHeader* header, Vec3f scale, Vec3s rot, Vec3f pos);
@@ -104,24 +289,34 @@ struct Collision {
 
   // Run wall and ceiling checks, displacing the intended position
   Vec3f runChecks(Vec3f prevPos, Vec3f intendedPos, f32 wallCheckHeight, f32 wallCheckRadius,
-                  CollisionPoly** wallPoly, CollisionPoly** floorPoly, int* dynaId, f32* floorHeight);
+                  CollisionPoly** wallPoly, CollisionPoly** floorPoly, int* dynaId, f32* floorHeight) const;
   Vec3f runChecks(Vec3f prevPos, Vec3f intendedPos, CollisionPoly** wallPoly,
-                  CollisionPoly** floorPoly, int* dynaId, f32* floorHeight);
-  Vec3f runChecks(Vec3f prevPos, Vec3f intendedPos, f32 wallCheckHeight, f32 wallCheckRadius);
-  Vec3f runChecks(Vec3f prevPos, Vec3f intendedPos);
+                  CollisionPoly** floorPoly, int* dynaId, f32* floorHeight) const;
+  Vec3f runChecks(Vec3f prevPos, Vec3f intendedPos, f32 wallCheckHeight, f32 wallCheckRadius) const;
+  Vec3f runChecks(Vec3f prevPos, Vec3f intendedPos) const;
   // Snap down to the nearest floor below the given position
-  Vec3f findFloor(Vec3f pos, CollisionPoly** outPoly, int* dynaId);
-  Vec3f findFloor(Vec3f pos);
+  Vec3f findFloor(Vec3f pos, CollisionPoly** outPoly, int* dynaId) const;
+  Vec3f findFloor(Vec3f pos) const;
+  // Same as runChecks and findFloor for many positions at once, which is
+  // faster than separate calls. The results are identical.
+  void runChecks(const CollisionCheck* checks, CollisionCheckResult* results,
+                 int count) const;
+  void findFloors(const Vec3f* positions, CollisionCheckResult* results,
+                  int count) const;
 
   // Run line test for entities
   Vec3f entityLineTest(Vec3f pos, Vec3f target, bool checkWalls,
                        bool checkFloors, bool checkCeilings,
-                       CollisionPoly** outPoly);
+                       CollisionPoly** outPoly) const;
   // Run line test for camera
-  Vec3f cameraLineTest(Vec3f pos, Vec3f target, CollisionPoly** outPoly);
+  Vec3f cameraLineTest(Vec3f pos, Vec3f target, CollisionPoly** outPoly) const;
+  // Same as cameraLineTest for many lines at once, which is faster than
+  // separate calls. The results are identical.
+  void cameraLineTests(const Vec3f* pos, const Vec3f* targets, Vec3f* results,
+                       CollisionPoly** outPolys, int count) const;
   // Find floor for camera
-  f32 cameraFindFloor(Vec3f pos, CollisionPoly** outPoly);
+  f32 cameraFindFloor(Vec3f pos, CollisionPoly** outPoly) const;
 
   // Get camera setting for floor poly
-  u16 getCameraSetting(CollisionPoly* poly, int dynaId);
+  u16 getCameraSetting(CollisionPoly* poly, int dynaId) const;
 };
@@ -220,3 +220,114 @@ extern CollisionHeader night_shop_sceneCollisionHeader_000644;
 extern CollisionHeader shop1_sceneCollisionHeader_0002B8;
 // Zora Shop
 extern CollisionHeader zoora_sceneCollisionHeader_000360;
+
+// Every scene above, by the name of its scene file
+struct SceneCollision {
+  const char* name;
+  CollisionHeader* header;
+};
+
+inline const SceneCollision sceneCollisions[] = {
+    {"Bmori1_scene", &Bmori1_sceneCollisionHeader_014054},
+    {"FIRE_bs_scene", &FIRE_bs_sceneCollisionHeader_002BCC},
+    {"HAKAdan_scene", &HAKAdan_sceneCollisionHeader_016394},
+    {"HAKAdanCH_scene", &HAKAdanCH_sceneCollisionHeader_00A558},
+    {"HAKAdan_bs_scene", &HAKAdan_bs_sceneCollisionHeader_00134C},
+    {"HIDAN_scene", &HIDAN_sceneCollisionHeader_01895C},
+    {"MIZUsin_scene", &MIZUsin_sceneCollisionHeader_013C04},
+    {"MIZUsin_bs_scene", &MIZUsin_bs_sceneCollisionHeader_001A34},
+    {"bdan_scene", &bdan_sceneCollisionHeader_013074},
+    {"bdan_boss_scene", &bdan_boss_sceneCollisionHeader_000E14},
+    {"ddan_scene", &ddan_sceneCollisionHeader_011D40},
+    {"ddan_boss_scene", &ddan_boss_sceneCollisionHeader_000E20},
+    {"ganon_scene", &ganon_sceneCollisionHeader_00E7A0},
+    {"ganon_boss_scene", &ganon_boss_sceneCollisionHeader_001520},
+    {"ganon_demo_scene", &ganon_demo_sceneCollisionHeader_001AA0},
+    {"ganon_final_scene", &ganon_final_sceneCollisionHeader_002354},
+    {"ganon_sonogo_scene", &ganon_sonogo_sceneCollisionHeader_0062CC},
+    {"ganon_tou_scene", &ganon_tou_sceneCollisionHeader_002610},
+    {"ganontika_scene", &ganontika_sceneCollisionHeader_019EAC},
+    {"ganontikasonogo_scene", &ganontikasonogo_sceneCollisionHeader_002ACC},
+    {"gerudoway_scene", &gerudoway_sceneCollisionHeader_0074EC},
+    {"ice_doukutu_scene", &ice_doukutu_sceneCollisionHeader_00F668},
+    {"jyasinboss_scene", &jyasinboss_sceneCollisionHeader_002B80},
+    {"jyasinzou_scene", &jyasinzou_sceneCollisionHeader_01680C},
+    {"men_scene", &men_sceneCollisionHeader_00F690},
+    {"moribossroom_scene", &moribossroom_sceneCollisionHeader_000B1C},
+    {"ydan_scene", &ydan_sceneCollisionHeader_00B618},
+    {"ydan_boss_scene", &ydan_boss_sceneCollisionHeader_000CFC},
+    {"bowling_scene", &bowling_sceneCollisionHeader_001A74},
+    {"daiyousei_izumi_scene", &daiyousei_izumi_sceneCollisionHeader_0043A4},
+    {"hairal_niwa_scene", &hairal_niwa_sceneCollisionHeader_0030B0},
+    {"hairal_niwa2_scene", &hairal_niwa2_sceneCollisionHeader_002CD8},
+    {"hairal_niwa_n_scene", &hairal_niwa_n_sceneCollisionHeader_0010C4},
+    {"hakasitarelay_scene", &hakasitarelay_sceneCollisionHeader_00C04C},
+    {"hut_scene", &hut_sceneCollisionHeader_0004DC},
+    {"hylia_labo_scene", &hylia_labo_sceneCollisionHeader_00105C},
+    {"impa_scene", &impa_sceneCollisionHeader_000CE0},
+    {"kakariko_scene", &kakariko_sceneCollisionHeader_000E68},
+    {"kenjyanoma_scene", &kenjyanoma_sceneCollisionHeader_00359C},
+    {"kokiri_home_scene", &kokiri_home_sceneCollisionHeader_000C8C},
+    {"kokiri_home3_scene", &kokiri_home3_sceneCollisionHeader_001774},
+    {"kokiri_home4_scene", &kokiri_home4_sceneCollisionHeader_001A84},
+    {"kokiri_home5_scene", &kokiri_home5_sceneCollisionHeader_0013DC},
+    {"labo_scene", &labo_sceneCollisionHeader_000EC4},
+    {"link_home_scene", &link_home_sceneCollisionHeader_000E4C},
+    {"mahouya_scene", &mahouya_sceneCollisionHeader_0009F4},
+    {"malon_stable_scene", &malon_stable_sceneCollisionHeader_000644},
+    {"miharigoya_scene", &miharigoya_sceneCollisionHeader_000B28},
+    {"nakaniwa_scene", &nakaniwa_sceneCollisionHeader_001BC8},
+    {"syatekijyou_scene", &syatekijyou_sceneCollisionHeader_001420},
+    {"takaraya_scene", &takaraya_sceneCollisionHeader_005178},
+    {"tent_scene", &tent_sceneCollisionHeader_00064C},
+    {"tokinoma_scene", &tokinoma_sceneCollisionHeader_0032F8},
+    {"yousei_izumi_tate_scene", &yousei_izumi_tate_sceneCollisionHeader_001FDC},
+    {"yousei_izumi_yoko_scene", &yousei_izumi_yoko_sceneCollisionHeader_0039A8},
+    {"enrui_scene", &enrui_sceneCollisionHeader_0003B4},
+    {"entra_n_scene", &entra_n_sceneCollisionHeader_0003F8},
+    {"hakaana_scene", &hakaana_sceneCollisionHeader_000A60},
+    {"hakaana2_scene", &hakaana2_sceneCollisionHeader_003058},
+    {"hakaana_ouke_scene", &hakaana_ouke_sceneCollisionHeader_002250},
+    {"hiral_demo_scene", &hiral_demo_sceneCollisionHeader_003548},
+    {"kakariko3_scene", &kakariko3_sceneCollisionHeader_000808},
+    {"kakusiana_scene", &kakusiana_sceneCollisionHeader_00B7F0},
+    {"kinsuta_scene", &kinsuta_sceneCollisionHeader_0015E4},
+    {"market_alley_scene", &market_alley_sceneCollisionHeader_001218},
+    {"market_alley_n_scene", &market_alley_n_sceneCollisionHeader_0012C0},
+    {"market_day_scene", &market_day_sceneCollisionHeader_002640},
+    {"market_night_scene", &market_night_sceneCollisionHeader_0025F8},
+    {"market_ruins_scene", &market_ruins_sceneCollisionHeader_0015F8},
+    {"shrine_scene", &shrine_sceneCollisionHeader_0014AC},
+    {"shrine_n_scene", &shrine_n_sceneCollisionHeader_0014D4},
+    {"shrine_r_scene", &shrine_r_sceneCollisionHeader_00145C},
+    {"turibori_scene", &turibori_sceneCollisionHeader_001CAC},
+    {"entra_scene", &entra_sceneCollisionHeader_0003B4},
+    {"souko_scene", &souko_sceneCollisionHeader_0043E0},
+    {"spot00_scene", &spot00_sceneCollisionHeader_008464},
+    {"spot01_scene", &spot01_sceneCollisionHeader_004A1C},
+    {"spot02_scene", &spot02_sceneCollisionHeader_003C54},
+    {"spot03_scene", &spot03_sceneCollisionHeader_006580},
+    {"spot04_scene", &spot04_sceneCollisionHeader_008918},
+    {"spot05_scene", &spot05_sceneCollisionHeader_003F4C},
+    {"spot06_scene", &spot06_sceneCollisionHeader_0055AC},
+    {"spot07_scene", &spot07_sceneCollisionHeader_003824},
+    {"spot08_scene", &spot08_sceneCollisionHeader_002CE0},
+    {"spot09_scene", &spot09_sceneCollisionHeader_002128},
+    {"spot10_scene", &spot10_sceneCollisionHeader_00AC98},
+    {"spot11_scene", &spot11_sceneCollisionHeader_004EE4},
+    {"spot12_scene", &spot12_sceneCollisionHeader_005030},
+    {"spot13_scene", &spot13_sceneCollisionHeader_003A00},
+    {"spot15_scene", &spot15_sceneCollisionHeader_003CE8},
+    {"spot16_scene", &spot16_sceneCollisionHeader_003D10},
+    {"spot17_scene", &spot17_sceneCollisionHeader_0045A4},
+    {"spot18_scene", &spot18_sceneCollisionHeader_0059AC},
+    {"spot20_scene", &spot20_sceneCollisionHeader_002948},
+    {"alley_shop_scene", &alley_shop_sceneCollisionHeader_000584},
+    {"drag_scene", &drag_sceneCollisionHeader_0003C0},
+    {"face_shop_scene", &face_shop_sceneCollisionHeader_000338},
+    {"golon_scene", &golon_sceneCollisionHeader_000368},
+    {"kokiri_shop_scene", &kokiri_shop_sceneCollisionHeader_000950},
+    {"night_shop_scene", &night_shop_sceneCollisionHeader_000644},
+    {"shop1_scene", &shop1_sceneCollisionHeader_0002B8},
+    {"zoora_scene", &zoora_sceneCollisionHeader_000360},
+};
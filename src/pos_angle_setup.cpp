@@ -4,6 +4,7 @@
 #include "animation.hpp"
 #include "animation_data.hpp"
 #include "camera.hpp"
+#include "camera_cache.hpp"
 #include "collider.hpp"
 #include "sys_math.hpp"
 #include "sys_math3d.hpp"
@@ -183,6 +184,7 @@ PosAngleSetup::PosAngleSetup(Collision* col, Vec3f initialPos, u16 initialAngle,
     : col(col),
       minBounds(minBounds),
       maxBounds(maxBounds),
+      cameraCache(nullptr),
       pos(initialPos),
       angle(initialAngle),
       targeted(true),
@@ -192,13 +194,14 @@ PosAngleSetup::PosAngleSetup(Collision* col, Vec3f initialPos, u16 initialAngle,
       cameraSetting(1),  // TODO: what should we default to?
       cameraStable(false),
       cameraAngle(0),
+      cameraValid(false),
       canTargetWall(false),
       targetWallAngle(0) {
   f32 floorHeight;
   this->col->runChecks(
       this->pos, translate(this->pos, this->angle, 0.0f, -5.0f),
       &this->wallPoly, &this->floorPoly, &this->dynaId, &floorHeight);
-  updateCameraAngle();
+  updateCameraSetting();
   updateTargetWall();
 }
 
@@ -241,6 +244,7 @@ bool PosAngleSetup::cameraTurn(u16 offset) {
     return false;
   }
 
+  updateCamera();
   if (!this->cameraStable) {
     return false;
   }
@@ -687,9 +691,7 @@ bool PosAngleSetup::doAction(Action action) {
   return false;
 }
 
-void PosAngleSetup::updateCameraAngle() {
-  this->cameraStable = false;
-
+void PosAngleSetup::updateCameraSetting() {
   if (!this->floorPoly) {
     return;
   }
@@ -698,6 +700,41 @@ void PosAngleSetup::updateCameraAngle() {
   if (setting != 0) {
     this->cameraSetting = setting;
   }
+}
+
+void PosAngleSetup::updateCamera() {
+  u32 x = floatToInt(this->pos.x);
+  u32 y = floatToInt(this->pos.y);
+  u32 z = floatToInt(this->pos.z);
+  bool onFloor = this->floorPoly != NULL;
+  u64 dynaKey = this->col->dyna.key();
+  if (this->cameraValid && this->cameraX == x && this->cameraY == y &&
+      this->cameraZ == z && this->cameraFacingAngle == this->angle &&
+      this->cameraInputSetting == this->cameraSetting &&
+      this->cameraOnFloor == onFloor && this->cameraDynaKey == dynaKey) {
+    return;
+  }
+  this->cameraValid = true;
+  this->cameraX = x;
+  this->cameraY = y;
+  this->cameraZ = z;
+  this->cameraFacingAngle = this->angle;
+  this->cameraInputSetting = this->cameraSetting;
+  this->cameraOnFloor = onFloor;
+  this->cameraDynaKey = dynaKey;
+
+  this->cameraStable = false;
+
+  if (!onFloor) {
+    return;
+  }
+
+  CameraKey key = {this->col, dynaKey, x, y, z, this->angle,
+                   this->cameraSetting};
+  if (this->cameraCache && this->cameraCache->find(key, &this->cameraStable,
+                                                   &this->cameraAngle)) {
+    return;
+  }
 
   Camera camera(this->col);
   camera.initParallel(this->pos, this->angle, this->cameraSetting);
@@ -718,6 +755,10 @@ void PosAngleSetup::updateCameraAngle() {
 
     cameraAngle = newCameraAngle;
   }
+
+  if (this->cameraCache) {
+    this->cameraCache->insert(key, this->cameraStable, this->cameraAngle);
+  }
 }
 
 void PosAngleSetup::updateTargetWall() {
@@ -751,7 +792,7 @@ bool PosAngleSetup::performAction(Action action) {
     return false;
   }
 
-  updateCameraAngle();
+  updateCameraSetting();
   updateTargetWall();
   return true;
 }
@@ -74,6 +74,7 @@ int actionCost(Action prevAction, Action action);
 int actionsCost(const std::vector<Action>& action);
 
 struct SwordSlash;
+struct CameraCache;
 
 struct Collider {
   Vec3s pos;
@@ -86,6 +87,8 @@ struct PosAngleSetup {
   Collision* col;
   Vec3f minBounds;
   Vec3f maxBounds;
+  // Settled cameras shared with other setups, or nullptr
+  CameraCache* cameraCache;
   // Current state
   Vec3f pos;
   u16 angle;
@@ -94,10 +97,21 @@ struct PosAngleSetup {
   CollisionPoly* wallPoly;
   CollisionPoly* floorPoly;
   int dynaId;
-  // Camera data
+  // Camera data. Simulating the camera is expensive and most actions don't
+  // need it, so cameraStable and cameraAngle are only brought up to date by
+  // updateCamera().
   u16 cameraSetting;
   bool cameraStable;
   u16 cameraAngle;
+  // Whether the camera has been simulated, and the inputs it was simulated for
+  bool cameraValid;
+  u32 cameraX;
+  u32 cameraY;
+  u32 cameraZ;
+  u16 cameraFacingAngle;
+  u16 cameraInputSetting;
+  bool cameraOnFloor;
+  u64 cameraDynaKey;
   // Wall interaction for targeting
   bool canTargetWall;
   u16 targetWallAngle;
@@ -114,6 +128,10 @@ struct PosAngleSetup {
   bool performAction(Action action);
   bool performActions(const std::vector<Action>& actions);
 
+  // Simulates the camera for the current position and angle, unless it was
+  // already simulated for them.
+  void updateCamera();
+
  private:
   bool ensureTargeted();
   bool targetWall();
@@ -133,6 +151,6 @@ struct PosAngleSetup {
   bool crouchStab();
 
   bool doAction(Action action);
-  void updateCameraAngle();
+  void updateCameraSetting();
   void updateTargetWall();
 };
@@ -0,0 +1,167 @@
+#include "progress.hpp"
+
+#include <cstdio>
+
+ProgressReporter::ProgressReporter(unsigned long long total,
+                                   std::string statusFile)
+    : total(total), statusFile(std::move(statusFile)) {
+  this->startTime = std::chrono::steady_clock::now();
+  this->lastReportTime = this->startTime;
+  this->thread = std::thread([this] { run(); });
+}
+
+ProgressReporter::~ProgressReporter() { stop(); }
+
+ProgressCounters* ProgressReporter::addCounters() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return &this->counters.emplace_back();
+}
+
+void ProgressReporter::setStatus(std::string text) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->status = std::move(text);
+}
+
+SearchStats ProgressReporter::stats() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  SearchStats stats;
+  for (const ProgressCounters& c : this->counters) {
+    SearchStats s = c.stats();
+    stats.tested += s.tested;
+    stats.close += s.close;
+    stats.found += s.found;
+  }
+  return stats;
+}
+
+ProgressBounds ProgressReporter::bounds() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  ProgressBounds bounds;
+  for (const ProgressCounters& c : this->counters) {
+    ProgressBounds b = c.bounds();
+    bounds.angleMin = std::min(bounds.angleMin, b.angleMin);
+    bounds.angleMax = std::max(bounds.angleMax, b.angleMax);
+    bounds.xMin = std::min(bounds.xMin, b.xMin);
+    bounds.xMax = std::max(bounds.xMax, b.xMax);
+    bounds.zMin = std::min(bounds.zMin, b.zMin);
+    bounds.zMax = std::max(bounds.zMax, b.zMax);
+  }
+  return bounds;
+}
+
+void ProgressReporter::stop() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->thread.joinable()) {
+      return;
+    }
+    this->stopping = true;
+  }
+  this->stopCond.notify_all();
+  this->thread.join();
+  report(true);
+}
+
+void ProgressReporter::run() {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (!this->stopCond.wait_for(lock, std::chrono::seconds(1),
+                                  [this] { return this->stopping; })) {
+    lock.unlock();
+    report(false);
+    lock.lock();
+    for (ProgressCounters& c : this->counters) {
+      c.tick.store(true, std::memory_order_relaxed);
+    }
+  }
+}
+
+// Formats a number of seconds as h:mm:ss.
+static std::string formatDuration(f64 seconds) {
+  long long s = (long long)seconds;
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%lld:%02lld:%02lld", s / 3600, s / 60 % 60,
+           s % 60);
+  return buf;
+}
+
+void ProgressReporter::report(bool done) {
+  SearchStats stats = this->stats();
+  ProgressBounds bounds = this->bounds();
+  std::string status;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    status = this->status;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  f64 elapsed = std::chrono::duration<f64>(now - this->startTime).count();
+  f64 interval =
+      std::chrono::duration<f64>(now - this->lastReportTime).count();
+  f64 rate = interval > 0 ? (stats.tested - this->lastTested) / interval : 0.0;
+  this->lastReportTime = now;
+  this->lastTested = stats.tested;
+  // Based on the average rate, which is steadier than the current one
+  f64 eta = -1.0;
+  if (this->total > 0 && stats.tested > 0) {
+    f64 remaining = this->total > stats.tested ? this->total - stats.tested : 0;
+    eta = remaining * elapsed / stats.tested;
+  }
+
+  if (!done) {
+    fprintf(stderr, "tested=%llu close=%llu found=%llu rate=%.0f/s elapsed=%s",
+            stats.tested, stats.close, stats.found, rate,
+            formatDuration(elapsed).c_str());
+    if (eta >= 0) {
+      fprintf(stderr, " eta=%s", formatDuration(eta).c_str());
+    }
+    if (!bounds.empty()) {
+      fprintf(stderr,
+              " amin=%04x amax=%04x xmin=%.3f xmax=%.3f zmin=%.3f zmax=%.3f",
+              (u16)bounds.angleMin, (u16)bounds.angleMax, bounds.xMin,
+              bounds.xMax, bounds.zMin, bounds.zMax);
+    }
+    if (!status.empty()) {
+      fprintf(stderr, " %s", status.c_str());
+    }
+    fprintf(stderr, " ...\n");
+  }
+
+  if (this->statusFile.empty()) {
+    return;
+  }
+  // Write to a temporary file first so readers never see a partial status
+  std::string tmpFile = this->statusFile + ".tmp";
+  FILE* f = fopen(tmpFile.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "could not write status file %s\n", tmpFile.c_str());
+    return;
+  }
+  fprintf(f,
+          "{\"tested\":%llu,\"close\":%llu,\"found\":%llu,\"rate\":%.0f,"
+          "\"elapsed\":%.1f,\"total\":%llu,",
+          stats.tested, stats.close, stats.found, rate, elapsed, this->total);
+  if (eta >= 0) {
+    fprintf(f, "\"eta\":%.1f,", eta);
+  } else {
+    fprintf(f, "\"eta\":null,");
+  }
+  if (!bounds.empty()) {
+    fprintf(f,
+            "\"bounds\":{\"angleMin\":%d,\"angleMax\":%d,\"xMin\":%.9g,"
+            "\"xMax\":%.9g,\"zMin\":%.9g,\"zMax\":%.9g},",
+            (u16)bounds.angleMin, (u16)bounds.angleMax, bounds.xMin,
+            bounds.xMax, bounds.zMin, bounds.zMax);
+  } else {
+    fprintf(f, "\"bounds\":null,");
+  }
+  fprintf(f, "\"status\":\"");
+  for (char c : status) {
+    if (c == '"' || c == '\\') {
+      fputc('\\', f);
+    }
+    fputc(c, f);
+  }
+  fprintf(f, "\",\"done\":%s}\n", done ? "true" : "false");
+  fclose(f);
+  rename(tmpFile.c_str(), this->statusFile.c_str());
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "global.hpp"
+
+struct SearchStats {
+  unsigned long long tested = 0;
+  unsigned long long close = 0;
+  unsigned long long found = 0;
+};
+
+// Bounds of the points found by a position/angle range search.
+struct ProgressBounds {
+  int angleMin = std::numeric_limits<int>::max();
+  int angleMax = std::numeric_limits<int>::lowest();
+  f32 xMin = std::numeric_limits<f32>::max();
+  f32 xMax = std::numeric_limits<f32>::lowest();
+  f32 zMin = std::numeric_limits<f32>::max();
+  f32 zMax = std::numeric_limits<f32>::lowest();
+
+  bool empty() const { return angleMin > angleMax; }
+};
+
+// Counters for a single search thread. Only the owning thread updates them, so
+// an increment is a plain load and store rather than a locked instruction, and
+// the ProgressReporter thread reads them concurrently.
+struct ProgressCounters {
+  std::atomic<unsigned long long> tested = 0;
+  std::atomic<unsigned long long> close = 0;
+  std::atomic<unsigned long long> found = 0;
+  // Bounds of the found points, for position/angle range searches.
+  std::atomic<int> angleMin = std::numeric_limits<int>::max();
+  std::atomic<int> angleMax = std::numeric_limits<int>::lowest();
+  std::atomic<f32> xMin = std::numeric_limits<f32>::max();
+  std::atomic<f32> xMax = std::numeric_limits<f32>::lowest();
+  std::atomic<f32> zMin = std::numeric_limits<f32>::max();
+  std::atomic<f32> zMax = std::numeric_limits<f32>::lowest();
+  // Set by the reporter after each report, so the search thread can do
+  // periodic work (status text, checkpoints) without checking the time.
+  std::atomic<bool> tick = false;
+
+  template <typename T>
+  static void set(std::atomic<T>* counter, T value) {
+    counter->store(value, std::memory_order_relaxed);
+  }
+
+  template <typename T>
+  static T get(const std::atomic<T>& counter) {
+    return counter.load(std::memory_order_relaxed);
+  }
+
+  void addTested(unsigned long long n = 1) { set(&tested, get(tested) + n); }
+  void addClose() { set(&close, get(close) + 1); }
+  void addFound() { set(&found, get(found) + 1); }
+
+  // Counts a found point and widens the bounds.
+  void addFound(int angle, f32 x, f32 z) {
+    addFound();
+    set(&angleMin, std::min(get(angleMin), angle));
+    set(&angleMax, std::max(get(angleMax), angle));
+    set(&xMin, std::min(get(xMin), x));
+    set(&xMax, std::max(get(xMax), x));
+    set(&zMin, std::min(get(zMin), z));
+    set(&zMax, std::max(get(zMax), z));
+  }
+
+  // Returns true once after each report.
+  bool ticked() {
+    if (!get(tick)) {
+      return false;
+    }
+    set(&tick, false);
+    return true;
+  }
+
+  SearchStats stats() const { return {get(tested), get(close), get(found)}; }
+  ProgressBounds bounds() const {
+    return {get(angleMin), get(angleMax), get(xMin),
+            get(xMax),     get(zMin),     get(zMax)};
+  }
+  void setStats(const SearchStats& stats) {
+    set(&tested, stats.tested);
+    set(&close, stats.close);
+    set(&found, stats.found);
+  }
+};
+
+// Prints the combined progress of all registered counters to stderr once a
+// second from a background thread: the counters, the rate in nodes/s, the
+// elapsed time, the ETA when the total number of nodes is known, the bounds of
+// the found points if any, and a status text set by the search. It can also
+// write the same information as a JSON object to a status file, which is
+// replaced atomically on each report.
+struct ProgressReporter {
+  unsigned long long total;  // Total number of nodes, or 0 if unknown.
+  std::string statusFile;
+
+  std::mutex mutex;
+  std::deque<ProgressCounters> counters;
+  std::string status;
+
+  std::chrono::steady_clock::time_point startTime;
+  std::chrono::steady_clock::time_point lastReportTime;
+  unsigned long long lastTested = 0;
+
+  std::condition_variable stopCond;
+  bool stopping = false;
+  std::thread thread;
+
+  ProgressReporter(unsigned long long total = 0, std::string statusFile = "");
+  // Stops reporting.
+  ~ProgressReporter();
+
+  ProgressReporter(const ProgressReporter&) = delete;
+  ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+  // Returns counters for a new search thread. They stay valid until the
+  // reporter is destroyed.
+  ProgressCounters* addCounters();
+  // Sets the text printed at the end of the next reports.
+  void setStatus(std::string text);
+  // Returns the sum of all counters.
+  SearchStats stats();
+  // Returns the combined bounds of the found points.
+  ProgressBounds bounds();
+
+  // Stops the reporter thread and writes the final status file.
+  void stop();
+
+  void run();
+  void report(bool done);
+};
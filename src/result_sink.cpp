@@ -0,0 +1,361 @@
+#include "result_sink.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+SearchResult::SearchResult(int cost, Vec3f startPos, u16 startAngle,
+                           const PosAngleSetup& setup,
+                           const std::vector<Action>& actions)
+    : cost(cost),
+      startPos(startPos),
+      startAngle(startAngle),
+      pos(setup.pos),
+      angle(setup.angle),
+      actions(actions) {}
+
+SearchResult& SearchResult::addInt(const char* name, s32 value) {
+  this->fields.push_back({name, ResultField::INT, (u32)value});
+  return *this;
+}
+
+SearchResult& SearchResult::addHex(const char* name, u16 value) {
+  this->fields.push_back({name, ResultField::HEX, value});
+  return *this;
+}
+
+SearchResult& SearchResult::addFloat(const char* name, f32 value) {
+  this->fields.push_back({name, ResultField::FLOAT, floatToInt(value)});
+  return *this;
+}
+
+SearchResult& SearchResult::addText(const char* name, std::string text) {
+  this->fields.push_back({name, ResultField::TEXT, 0, std::move(text)});
+  return *this;
+}
+
+SearchResult& SearchResult::addPlainFloat(const char* name, f32 value) {
+  this->fields.push_back({name, ResultField::PLAIN_FLOAT, floatToInt(value)});
+  return *this;
+}
+
+SearchResult& SearchResult::customLayout() {
+  this->standardLayout = false;
+  return *this;
+}
+
+void formatResult(const SearchResult& result, std::string* out) {
+  char buf[512];
+  if (result.standardLayout) {
+    snprintf(buf, sizeof(buf),
+             "cost=%d startAngle=%04x startx=%.9g startz=%.9g angle=%04x "
+             "x=%.9g (%08x) z=%.9g (%08x)",
+             result.cost, result.startAngle, result.startPos.x,
+             result.startPos.z, result.angle, result.pos.x,
+             floatToInt(result.pos.x), result.pos.z, floatToInt(result.pos.z));
+  } else {
+    snprintf(buf, sizeof(buf), "cost=%d", result.cost);
+  }
+  *out += buf;
+
+  for (const ResultField& field : result.fields) {
+    switch (field.type) {
+      case ResultField::INT:
+        snprintf(buf, sizeof(buf), " %s=%d", field.name.c_str(),
+                 (s32)field.value);
+        break;
+      case ResultField::HEX:
+        snprintf(buf, sizeof(buf), " %s=%04x", field.name.c_str(),
+                 field.value);
+        break;
+      case ResultField::FLOAT:
+        snprintf(buf, sizeof(buf), " %s=%.9g (%08x)", field.name.c_str(),
+                 intToFloat(field.value), field.value);
+        break;
+      case ResultField::TEXT:
+        snprintf(buf, sizeof(buf), " %s=", field.name.c_str());
+        break;
+      case ResultField::PLAIN_FLOAT:
+        snprintf(buf, sizeof(buf), " %s=%.9g", field.name.c_str(),
+                 intToFloat(field.value));
+        break;
+    }
+    *out += buf;
+    if (field.type == ResultField::TEXT) {
+      *out += field.text;
+    }
+  }
+
+  *out += " actions=";
+  *out += actionNames(result.actions);
+  *out += "\n";
+}
+
+static const char RESULT_MAGIC[8] = {'O', 'O', 'T', 'R', 'E', 'S', '2', '\n'};
+
+template <typename T>
+static void append(std::string* out, T value) {
+  out->append((const char*)&value, sizeof(value));
+}
+
+void writeResultHeader(FILE* f) {
+  fwrite(RESULT_MAGIC, 1, sizeof(RESULT_MAGIC), f);
+}
+
+void writeResult(const SearchResult& result, std::string* out) {
+  append<u32>(out, result.cost);
+  append(out, result.startPos);
+  append(out, result.startAngle);
+  append(out, result.pos);
+  append(out, result.angle);
+  append<u8>(out, result.standardLayout);
+  append<u8>(out, result.actions.size());
+  for (Action action : result.actions) {
+    append<u8>(out, action);
+  }
+  append<u8>(out, result.fields.size());
+  for (const ResultField& field : result.fields) {
+    append<u8>(out, field.type);
+    append<u8>(out, field.name.size());
+    *out += field.name;
+    if (field.type == ResultField::TEXT) {
+      append<u16>(out, field.text.size());
+      *out += field.text;
+    } else {
+      append(out, field.value);
+    }
+  }
+}
+
+bool readResultHeader(FILE* f) {
+  char magic[sizeof(RESULT_MAGIC)];
+  return fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+         memcmp(magic, RESULT_MAGIC, sizeof(magic)) == 0;
+}
+
+template <typename T>
+static bool read(FILE* f, T* value) {
+  return fread(value, sizeof(T), 1, f) == 1;
+}
+
+static bool readString(FILE* f, size_t length, std::string* s) {
+  s->resize(length);
+  return length == 0 || fread(s->data(), 1, length, f) == length;
+}
+
+bool readResult(FILE* f, SearchResult* result) {
+  u32 cost;
+  if (!read(f, &cost)) {
+    return false;
+  }
+  result->cost = cost;
+
+  u8 standardLayout;
+  u8 numActions;
+  if (!read(f, &result->startPos) || !read(f, &result->startAngle) ||
+      !read(f, &result->pos) || !read(f, &result->angle) ||
+      !read(f, &standardLayout) || !read(f, &numActions)) {
+    return false;
+  }
+  result->standardLayout = standardLayout;
+  result->actions.clear();
+  for (int i = 0; i < numActions; i++) {
+    u8 action;
+    if (!read(f, &action)) {
+      return false;
+    }
+    result->actions.push_back((Action)action);
+  }
+
+  u8 numFields;
+  if (!read(f, &numFields)) {
+    return false;
+  }
+  result->fields.resize(numFields);
+  for (ResultField& field : result->fields) {
+    u8 type;
+    u8 nameLength;
+    if (!read(f, &type) || !read(f, &nameLength) ||
+        !readString(f, nameLength, &field.name)) {
+      return false;
+    }
+    field.type = (ResultField::Type)type;
+    if (field.type == ResultField::TEXT) {
+      u16 textLength;
+      if (!read(f, &textLength) || !readString(f, textLength, &field.text)) {
+        return false;
+      }
+      field.value = 0;
+    } else {
+      field.text.clear();
+      if (!read(f, &field.value)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static std::mutex sinksMutex;
+static std::vector<ResultSink*> sinks;
+
+ResultSink::ResultSink(FILE* file, Format format, size_t capacity)
+    : file(file), format(format) {
+  size_t size = 1;
+  while (size < capacity) {
+    size *= 2;
+  }
+  this->cells.reset(new Cell[size]);
+  for (size_t i = 0; i < size; i++) {
+    this->cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  this->mask = size - 1;
+
+  std::lock_guard<std::mutex> lock(sinksMutex);
+  sinks.push_back(this);
+}
+
+ResultSink::~ResultSink() {
+  {
+    std::lock_guard<std::mutex> lock(sinksMutex);
+    sinks.erase(std::find(sinks.begin(), sinks.end(), this));
+  }
+  if (this->writer.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->stopping = true;
+    }
+    this->wakeWriter.notify_one();
+    this->writer.join();
+  }
+}
+
+bool ResultSink::tryPush(SearchResult* result) {
+  size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+  while (true) {
+    Cell* cell = &this->cells[pos & this->mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+    if (diff == 0) {
+      if (this->enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                                 std::memory_order_relaxed)) {
+        cell->result = std::move(*result);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // Full
+      return false;
+    } else {
+      pos = this->enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool ResultSink::tryPop(SearchResult* result) {
+  Cell* cell = &this->cells[this->dequeuePos & this->mask];
+  size_t sequence = cell->sequence.load(std::memory_order_acquire);
+  if (sequence != this->dequeuePos + 1) {
+    return false;
+  }
+  *result = std::move(cell->result);
+  cell->sequence.store(this->dequeuePos + this->mask + 1,
+                       std::memory_order_release);
+  this->dequeuePos++;
+  return true;
+}
+
+void ResultSink::push(SearchResult result) {
+  std::call_once(this->started, [this] {
+    this->writer = std::thread([this] { runWriter(); });
+  });
+  while (!tryPush(&result)) {
+    std::this_thread::yield();
+  }
+  // The writer sets writerIdle before checking pushed, so either it sees this
+  // result or this sees that it is idle
+  this->pushed++;
+  if (this->writerIdle.load()) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->wakeWriter.notify_one();
+  }
+}
+
+void ResultSink::flush() {
+  unsigned long long target = this->pushed.load();
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->resultsWritten.wait(lock,
+                            [&] { return this->written.load() >= target; });
+}
+
+void ResultSink::runWriter() {
+  const size_t BATCH_SIZE = 1 << 20;
+
+  std::string buffer;
+  buffer.reserve(BATCH_SIZE + 4096);
+  if (this->format == BINARY) {
+    writeResultHeader(this->file);
+  }
+
+  SearchResult result;
+  unsigned long long count = 0;
+  while (true) {
+    // Anything pushed before stopping is set will be popped below
+    bool stop = this->stopping.load();
+    bool idle = true;
+    while (tryPop(&result)) {
+      idle = false;
+      if (this->format == TEXT) {
+        formatResult(result, &buffer);
+      } else {
+        writeResult(result, &buffer);
+      }
+      count++;
+      if (buffer.size() >= BATCH_SIZE) {
+        break;
+      }
+    }
+
+    if (!buffer.empty()) {
+      fwrite(buffer.data(), 1, buffer.size(), this->file);
+      buffer.clear();
+    }
+    if (idle) {
+      if (count > 0) {
+        fflush(this->file);
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->written += count;
+        }
+        this->resultsWritten.notify_all();
+        count = 0;
+      }
+      if (stop) {
+        break;
+      }
+
+      // Sleep until a result is pushed. pushed can briefly lag behind the
+      // results already popped, which only causes an extra wakeup.
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->writerIdle = true;
+      this->wakeWriter.wait(lock, [this] {
+        return this->stopping.load() || this->pushed.load() > this->dequeuePos;
+      });
+      this->writerIdle = false;
+    }
+  }
+  fflush(this->file);
+}
+
+void flushResultSinks() {
+  std::lock_guard<std::mutex> lock(sinksMutex);
+  for (ResultSink* sink : sinks) {
+    sink->flush();
+  }
+}
+
+void setResultSinksFormat(ResultSink::Format format) {
+  std::lock_guard<std::mutex> lock(sinksMutex);
+  for (ResultSink* sink : sinks) {
+    sink->format = format;
+  }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "global.hpp"
+#include "pos_angle_setup.hpp"
+
+// Extra value attached to a search result.
+struct ResultField {
+  enum Type : u8 {
+    INT,    // Printed as %d
+    HEX,    // Printed as %04x
+    FLOAT,  // Printed as %.9g (%08x)
+    TEXT,
+    PLAIN_FLOAT,  // Printed as %.9g
+  };
+
+  std::string name;
+  Type type;
+  u32 value;  // Integer value or float bits
+  std::string text;
+};
+
+// A setup found by a search, in the format of the usual output line:
+//
+//   cost=... startAngle=... startx=... startz=... angle=... x=... (...) z=...
+//   (...) [extra fields] actions=...
+//
+// Programs whose lines have a different layout can call customLayout() to
+// print only "cost=... [extra fields] actions=..." and add the positions they
+// print as fields themselves.
+struct SearchResult {
+  int cost;
+  Vec3f startPos;
+  u16 startAngle;
+  Vec3f pos;
+  u16 angle;
+  std::vector<Action> actions;
+  std::vector<ResultField> fields;
+  bool standardLayout = true;
+
+  SearchResult() = default;
+  SearchResult(int cost, Vec3f startPos, u16 startAngle,
+               const PosAngleSetup& setup, const std::vector<Action>& actions);
+
+  SearchResult& addInt(const char* name, s32 value);
+  SearchResult& addHex(const char* name, u16 value);
+  SearchResult& addFloat(const char* name, f32 value);
+  SearchResult& addText(const char* name, std::string text);
+  SearchResult& addPlainFloat(const char* name, f32 value);
+  SearchResult& customLayout();
+};
+
+// Appends the text format of the result (one line) to the string.
+void formatResult(const SearchResult& result, std::string* out);
+
+// Binary format: a header followed by records of
+//
+//   u32 cost, f32 startPos[3], u16 startAngle, f32 pos[3], u16 angle,
+//   u8 standardLayout, u8 numActions, u8 actions[numActions], u8 numFields,
+//   {u8 type, u8 nameLength, name, u32 value or (u16 length, text)}...
+//
+// in native byte order. Action values depend on the order of ACTIONS.
+void writeResultHeader(FILE* f);
+void writeResult(const SearchResult& result, std::string* out);
+// Returns false if the header is missing or doesn't match this version.
+bool readResultHeader(FILE* f);
+// Returns false at the end of the file.
+bool readResult(FILE* f, SearchResult* result);
+
+// Writes search results from a background thread so that output functions
+// don't wait on formatting and syscalls. push() is lock-free and safe to call
+// from multiple search threads. Results are written in large batches while the
+// search produces them faster than they can be written, and otherwise as soon
+// as they are pushed. The writer thread sleeps while there is nothing to write.
+//
+// The writer thread is started on the first push, so a sink created before
+// searchSetupsWorkers forks its workers works in each worker.
+struct ResultSink {
+  enum Format { TEXT, BINARY };
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    SearchResult result;
+  };
+
+  FILE* file;
+  Format format;
+  // Bounded multi-producer queue (Dmitry Vyukov's algorithm); the writer
+  // thread is the only consumer.
+  std::unique_ptr<Cell[]> cells;
+  size_t mask;
+  std::atomic<size_t> enqueuePos = 0;
+  size_t dequeuePos = 0;
+
+  std::atomic<unsigned long long> pushed = 0;
+  std::atomic<unsigned long long> written = 0;
+  std::atomic<bool> stopping = false;
+  std::once_flag started;
+  std::thread writer;
+  // Set while the writer waits for results, so that push() knows to wake it
+  std::atomic<bool> writerIdle = false;
+  std::mutex mutex;
+  // Signalled when a result is pushed to an idle writer, and when stopping
+  std::condition_variable wakeWriter;
+  // Signalled when the writer has written and flushed results
+  std::condition_variable resultsWritten;
+
+  // The queue holds up to `capacity` results (rounded up to a power of 2).
+  // Pushing to a full queue waits for the writer.
+  ResultSink(FILE* file = stdout, Format format = TEXT,
+             size_t capacity = 1 << 14);
+  // Writes the remaining results.
+  ~ResultSink();
+
+  ResultSink(const ResultSink&) = delete;
+  ResultSink& operator=(const ResultSink&) = delete;
+
+  void push(SearchResult result);
+  // Blocks until all results pushed so far have been written and flushed.
+  void flush();
+
+  bool tryPush(SearchResult* result);
+  bool tryPop(SearchResult* result);
+  void runWriter();
+};
+
+// Flushes every live ResultSink, e.g. before a worker reports a finished shard.
+void flushResultSinks();
+// Sets the format of every live ResultSink. Must be called before anything is
+// pushed to them.
+void setResultSinksFormat(ResultSink::Format format);
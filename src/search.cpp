@@ -1 +1,569 @@
 #include "search.hpp"
+
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+
+#include "result_sink.hpp"
+
+SearchExecutor::SearchExecutor(int numThreads) : numThreads(numThreads) {
+  for (int i = 0; i < numThreads; i++) {
+    this->queues.emplace_back();
+  }
+}
+
+void SearchExecutor::push(int worker, SearchTask task) {
+  this->pending++;
+  {
+    Queue& queue = this->queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  if (hungry()) {
+    this->idleCond.notify_one();
+  }
+}
+
+std::optional<SearchTask> SearchExecutor::pop(int worker) {
+  while (true) {
+    // Take the most recent task from our own queue first, then try to steal
+    // the oldest task from the other workers.
+    for (int i = 0; i < this->numThreads; i++) {
+      int victim = (worker + i) % this->numThreads;
+      Queue& queue = this->queues[victim];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) {
+        continue;
+      }
+
+      std::optional<SearchTask> task;
+      if (victim == worker) {
+        task.emplace(std::move(queue.tasks.back()));
+        queue.tasks.pop_back();
+      } else {
+        task.emplace(std::move(queue.tasks.front()));
+        queue.tasks.pop_front();
+      }
+      return task;
+    }
+
+    if (this->pending == 0) {
+      this->idleCond.notify_all();
+      return std::nullopt;
+    }
+
+    // Wait for another worker to split off a subtree. The timeout covers
+    // wakeups that race with us going idle.
+    std::unique_lock<std::mutex> lock(this->idleMutex);
+    this->idle++;
+    this->idleCond.wait_for(lock, std::chrono::milliseconds(1));
+    this->idle--;
+  }
+}
+
+void SearchExecutor::finish() {
+  if (--this->pending == 0) {
+    this->idleCond.notify_all();
+  }
+}
+
+PosAngleGrid::PosAngleGrid(const PosAngleRange& range) {
+  for (int angle = range.angleMin; angle <= range.angleMax;
+       angle += range.angleStep) {
+    this->angles.push_back(angle);
+  }
+  for (f32 x = range.xMin; x <= range.xMax; x += range.xStep) {
+    this->xs.push_back(x);
+  }
+  for (f32 z = range.zMin; z <= range.zMax; z += range.zStep) {
+    this->zs.push_back(z);
+  }
+}
+
+void printPosAngleRangeStats(ProgressReporter* reporter) {
+  SearchStats stats = reporter->stats();
+  ProgressBounds bounds = reporter->bounds();
+  fprintf(stderr, "tested:%llu found:%llu", stats.tested, stats.found);
+  if (stats.found > 0) {
+    fprintf(stderr,
+            " amin:%04x amax:%04x xmin:%9.3f"
+            " xmax:%9.3f zmin:%9.3f zmax:%9.3f",
+            (u16)bounds.angleMin, (u16)bounds.angleMax, bounds.xMin,
+            bounds.xMax, bounds.zMin, bounds.zMax);
+  }
+  fprintf(stderr, "\n");
+}
+
+int searchThreads(const SearchParams& params) {
+  if (params.numThreads > 0) {
+    return params.numThreads;
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Allocating and touching hundreds of MiB can take longer than a small search
+// or shard, so the table and cache are kept for the whole process.
+static std::unique_ptr<TranspositionTable> sTranspositionTable;
+static int sTranspositionTableMB = 0;
+static std::unique_ptr<CameraCache> sCameraCache;
+static int sCameraCacheMB = 0;
+
+TranspositionTable* searchTranspositionTable(const SearchParams& params) {
+  if (params.transpositionTableMB <= 0) {
+    return nullptr;
+  }
+  if (sTranspositionTable &&
+      sTranspositionTableMB == params.transpositionTableMB) {
+    sTranspositionTable->clear();
+  } else {
+    // Free the old table first so both don't have to fit in memory
+    sTranspositionTable.reset();
+    sTranspositionTable = std::make_unique<TranspositionTable>(
+        (size_t)params.transpositionTableMB << 20);
+    sTranspositionTableMB = params.transpositionTableMB;
+  }
+  return sTranspositionTable.get();
+}
+
+CameraCache* searchCameraCache(const SearchParams& params) {
+  if (params.cameraCacheMB <= 0) {
+    return nullptr;
+  }
+  if (sCameraCache && sCameraCacheMB == params.cameraCacheMB) {
+    sCameraCache->clear();
+  } else {
+    sCameraCache.reset();
+    sCameraCache =
+        std::make_unique<CameraCache>((size_t)params.cameraCacheMB << 20);
+    sCameraCacheMB = params.cameraCacheMB;
+  }
+  return sCameraCache.get();
+}
+
+// Parses comma-separated action names from the configured actions.
+static bool parseActions(const SearchParams& params, char* names,
+                         std::vector<Action>* actions) {
+  for (char* name = strtok(names, ","); name; name = strtok(nullptr, ",")) {
+    auto it = std::find_if(
+        params.actions.begin(), params.actions.end(),
+        [&](Action action) { return strcmp(actionName(action), name) == 0; });
+    if (it == params.actions.end()) {
+      return false;
+    }
+    actions->push_back(*it);
+  }
+  return true;
+}
+
+std::string shardName(const SearchShard& shard) {
+  return std::to_string(shard.startIndex) + ":" +
+         std::to_string(shard.visitFrom) + ":" + actionNames(shard.prefix);
+}
+
+bool parseShard(const SearchParams& params, const std::string& name,
+                SearchShard* shard) {
+  char actions[8192] = "";
+  int n = sscanf(name.c_str(), "%d:%d:%8191s", &shard->startIndex,
+                 &shard->visitFrom, actions);
+  shard->prefix.clear();
+  return n >= 2 && shard->startIndex >= 0 &&
+         shard->startIndex < params.starts.size() &&
+         parseActions(params, actions, &shard->prefix) &&
+         shard->visitFrom >= 0 && shard->visitFrom <= shard->prefix.size();
+}
+
+std::vector<SearchShard> planShards(const SearchParams& params,
+                                    int numShards) {
+  auto filter = [](Vec3f, u16, const PosAngleSetup&, const std::vector<Action>&,
+                   int) { return true; };
+  return planShards(params, numShards, filter);
+}
+
+SearchCoordinator::SearchCoordinator(const SearchParams* params,
+                                     const std::vector<SearchShard>& shards,
+                                     int numWorkers)
+    : params(params), numWorkers(numWorkers) {
+  for (const SearchShard& shard : shards) {
+    this->queue.push_back({shard});
+  }
+}
+
+bool SearchCoordinator::run() {
+  // Writing to a crashed worker shouldn't kill the coordinator
+  signal(SIGPIPE, SIG_IGN);
+
+  while (true) {
+    while (this->workers.size() < this->numWorkers && !this->queue.empty()) {
+      if (startWorker()) {
+        return true;
+      }
+      assignShard(&this->workers.back());
+    }
+    if (this->workers.empty()) {
+      break;
+    }
+
+    std::vector<pollfd> fds;
+    for (const Worker& worker : this->workers) {
+      fds.push_back({worker.outputFd, POLLIN, 0});
+    }
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      continue;
+    }
+
+    // Backwards since workers that exited are removed
+    for (int i = fds.size() - 1; i >= 0; i--) {
+      if (!fds[i].revents) {
+        continue;
+      }
+      char buf[65536];
+      ssize_t n = read(fds[i].fd, buf, sizeof(buf));
+      if (n > 0) {
+        this->workers[i].buffer.append(buf, n);
+        readOutput(&this->workers[i]);
+      } else if (n == 0 || errno != EINTR) {
+        workerExited(i);
+      }
+    }
+  }
+
+  fprintf(stderr, "tested=%llu close=%llu found=%llu shards=%d failed=%d\n",
+          this->totals.tested, this->totals.close, this->totals.found,
+          this->numFinished, this->numFailed);
+  return false;
+}
+
+bool SearchCoordinator::startWorker() {
+  int shardPipe[2];
+  int outputPipe[2];
+  if (pipe(shardPipe) < 0 || pipe(outputPipe) < 0) {
+    fprintf(stderr, "could not create worker pipes\n");
+    exit(1);
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid < 0) {
+    fprintf(stderr, "could not start worker\n");
+    exit(1);
+  }
+
+  if (pid == 0) {
+    // Other workers' pipes must be closed for them to see EOF
+    for (const Worker& worker : this->workers) {
+      if (worker.shardFd >= 0) {
+        close(worker.shardFd);
+      }
+      close(worker.outputFd);
+    }
+    this->workers.clear();
+    close(shardPipe[1]);
+    close(outputPipe[0]);
+    dup2(outputPipe[1], STDOUT_FILENO);
+    close(outputPipe[1]);
+    this->shardInput = fdopen(shardPipe[0], "r");
+    return true;
+  }
+
+  close(shardPipe[0]);
+  close(outputPipe[1]);
+  Worker worker;
+  worker.pid = pid;
+  worker.shardFd = shardPipe[1];
+  worker.outputFd = outputPipe[0];
+  this->workers.push_back(std::move(worker));
+  return false;
+}
+
+void SearchCoordinator::assignShard(Worker* worker) {
+  if (this->queue.empty()) {
+    // No more work, so let the worker exit
+    if (worker->shardFd >= 0) {
+      close(worker->shardFd);
+      worker->shardFd = -1;
+    }
+    return;
+  }
+
+  worker->task = this->queue.front();
+  this->queue.pop_front();
+  worker->busy = true;
+  // If the worker has crashed, this fails and the shard is retried when its
+  // output pipe is closed.
+  std::string line = shardName(worker->task.shard) + "\n";
+  if (write(worker->shardFd, line.data(), line.size()) < 0) {
+    return;
+  }
+}
+
+void SearchCoordinator::readOutput(Worker* worker) {
+  while (true) {
+    size_t end = worker->buffer.find('\0');
+    if (end == std::string::npos) {
+      return;
+    }
+    size_t lineEnd = worker->buffer.find('\n', end);
+    if (lineEnd == std::string::npos) {
+      return;
+    }
+
+    fwrite(worker->buffer.data(), 1, end, stdout);
+    fflush(stdout);
+
+    SearchStats stats;
+    sscanf(worker->buffer.c_str() + end + 1, "done %llu %llu %llu",
+           &stats.tested, &stats.close, &stats.found);
+    this->totals.tested += stats.tested;
+    this->totals.close += stats.close;
+    this->totals.found += stats.found;
+    this->numFinished++;
+
+    worker->buffer.erase(0, lineEnd + 1);
+    worker->busy = false;
+    assignShard(worker);
+  }
+}
+
+void SearchCoordinator::workerExited(int index) {
+  Worker& worker = this->workers[index];
+  close(worker.outputFd);
+  if (worker.shardFd >= 0) {
+    close(worker.shardFd);
+  }
+  int status;
+  waitpid(worker.pid, &status, 0);
+
+  if (worker.busy) {
+    std::string name = shardName(worker.task.shard);
+    worker.task.attempts++;
+    if (worker.task.attempts < MAX_ATTEMPTS) {
+      fprintf(stderr, "worker %d failed on shard %s, retrying\n", worker.pid,
+              name.c_str());
+      this->queue.push_front(worker.task);
+    } else {
+      fprintf(stderr, "worker %d failed on shard %s, giving up\n", worker.pid,
+              name.c_str());
+      this->numFailed++;
+    }
+  }
+  this->workers.erase(this->workers.begin() + index);
+}
+
+bool SearchCoordinator::nextShard(SearchShard* shard) {
+  char line[8192];
+  if (!fgets(line, sizeof(line), this->shardInput)) {
+    return false;
+  }
+  line[strcspn(line, "\n")] = '\0';
+  if (!parseShard(*this->params, line, shard)) {
+    fprintf(stderr, "invalid shard %s\n", line);
+    exitWorker();
+  }
+  return true;
+}
+
+void SearchCoordinator::finishShard(const SearchStats& stats) {
+  // The shard's output has to come before the end marker
+  flushResultSinks();
+  fputc('\0', stdout);
+  printf("done %llu %llu %llu\n", stats.tested, stats.close, stats.found);
+  fflush(stdout);
+}
+
+void SearchCoordinator::exitWorker() {
+  flushResultSinks();
+  fflush(stdout);
+  fflush(stderr);
+  _exit(0);
+}
+
+void writeCheckpoint(const SearchParams& params, const SearchState& state,
+                     bool finished) {
+  // Resuming starts from this node, so everything output before it has to be
+  // written first
+  flushResultSinks();
+  fflush(stdout);
+
+  // Write to a temporary file first so a crash can't leave a partial
+  // checkpoint behind.
+  std::string tmpFile = params.checkpointFile + ".tmp";
+  FILE* f = fopen(tmpFile.c_str(), "w");
+  if (!f) {
+    fprintf(stderr, "could not write checkpoint %s\n", tmpFile.c_str());
+    return;
+  }
+  SearchStats stats = state.progress->stats();
+  fprintf(f,
+          "shard=%s start=%d tested=%llu close=%llu found=%llu finished=%d "
+          "actions=%s\n",
+          state.shard.c_str(), state.startIndex, stats.tested, stats.close,
+          stats.found, finished, actionNames(state.path).c_str());
+  fclose(f);
+  rename(tmpFile.c_str(), params.checkpointFile.c_str());
+}
+
+bool initCheckpoint(const SearchParams& params, SearchState* state) {
+  if (params.checkpointFile.empty()) {
+    return true;
+  }
+  if (searchThreads(params) > 1) {
+    fprintf(stderr,
+            "checkpoints are only supported for single-threaded searches\n");
+    return false;
+  }
+  state->checkpointing = true;
+  state->lastCheckpoint = time(nullptr);
+
+  if (!params.resume) {
+    return true;
+  }
+  FILE* f = fopen(params.checkpointFile.c_str(), "r");
+  if (!f) {
+    // Nothing to resume from
+    return true;
+  }
+
+  char shard[8192];
+  int startIndex;
+  unsigned long long tested;
+  unsigned long long close;
+  unsigned long long found;
+  int finished;
+  char actions[8192] = "";
+  int n = fscanf(f,
+                 "shard=%8191s start=%d tested=%llu close=%llu found=%llu "
+                 "finished=%d actions=%8191s",
+                 shard, &startIndex, &tested, &close, &found, &finished,
+                 actions);
+  fclose(f);
+  if (n < 6) {
+    fprintf(stderr, "could not read checkpoint %s\n",
+            params.checkpointFile.c_str());
+    return false;
+  }
+  if (shard != state->shard || startIndex < 0 ||
+      startIndex >= params.starts.size()) {
+    fprintf(stderr, "checkpoint %s is for a different search\n",
+            params.checkpointFile.c_str());
+    return false;
+  }
+  if (finished) {
+    fprintf(stderr,
+            "search already finished: tested=%llu close=%llu found=%llu\n",
+            tested, close, found);
+    return false;
+  }
+
+  std::vector<Action> path;
+  if (!parseActions(params, actions, &path)) {
+    fprintf(stderr, "checkpoint %s has unknown actions\n",
+            params.checkpointFile.c_str());
+    return false;
+  }
+
+  state->progress->setStats({tested, close, found});
+  state->startIndex = startIndex;
+  state->resuming = true;
+  state->resumePath = path;
+  fprintf(stderr, "resuming from start=%d actions=%s\n", startIndex,
+          actionNames(path).c_str());
+  return true;
+}
+
+bool inAngleRange(const SearchParams& params, u16 angle) {
+  if (params.angleMin <= params.angleMax) {
+    return params.angleMin <= angle && angle <= params.angleMax;
+  } else {
+    return params.angleMin <= angle || angle <= params.angleMax;
+  }
+}
+
+// Returns the cost of reaching the angle range with consecutive ESS turns in
+// one direction, or more than params.maxCost if that's impossible.
+int essCostToAngleRange(const SearchParams& params, u16 angle,
+                        const std::vector<Action>& path, Action ess) {
+  if (std::find(params.actions.begin(), params.actions.end(), ess) ==
+      params.actions.end()) {
+    return params.maxCost + 1;
+  }
+
+  int dir = ess == ROTATE_ESS_LEFT ? 1 : -1;
+  int cost = path.empty() ? actionCost(ess) : actionCost(path.back(), ess);
+  while (cost <= params.maxCost) {
+    angle += dir * ESS;
+    if (inAngleRange(params, angle)) {
+      return cost;
+    }
+    cost += actionCost(ess, ess);
+  }
+  return cost;
+}
+
+int estimateCostToGoal(const SearchParams& params, const PosAngleSetup& setup,
+                       const std::vector<Action>& path, bool* inGoal) {
+  Vec3f pos = setup.pos;
+
+  f32 xDist;
+  if (pos.x < params.xMin) {
+    xDist = params.xMin - pos.x;
+  } else if (pos.x > params.xMax) {
+    xDist = pos.x - params.xMax;
+  } else {
+    xDist = 0.0f;
+  }
+
+  f32 zDist;
+  if (pos.z < params.zMin) {
+    zDist = params.zMin - pos.z;
+  } else if (pos.z > params.zMax) {
+    zDist = pos.z - params.zMax;
+  } else {
+    zDist = 0.0f;
+  }
+
+  // Estimate minimum cost to reach goal area. A sidehop moves 12.75 units per
+  // frame.
+  int moveCost = ceilf(sqrtf(SQ(xDist) + SQ(zDist)) / 12.75f);
+
+  if (inAngleRange(params, setup.angle)) {
+    *inGoal = xDist == 0.0f && zDist == 0.0f;
+    return moveCost;
+  }
+  *inGoal = false;
+
+  // Every other action either keeps the angle, turns in place, or (for
+  // untargeting siderolls) moves and turns at once. Turning in place doesn't
+  // move Link, so its cost adds to the cost of moving.
+  int turnCost = std::min(
+      essCostToAngleRange(params, setup.angle, path, ROTATE_ESS_LEFT),
+      essCostToAngleRange(params, setup.angle, path, ROTATE_ESS_RIGHT));
+  int moveTurnCost = params.maxCost + 1;
+  for (Action action : params.actions) {
+    switch (action) {
+      case TARGET_WALL:
+      case ESS_TURN_UP:
+      case ESS_TURN_LEFT:
+      case ESS_TURN_RIGHT:
+      case ESS_TURN_DOWN:
+      case SHIELD_TURN_LEFT:
+      case SHIELD_TURN_RIGHT:
+      case SHIELD_TURN_DOWN:
+        turnCost = std::min(turnCost, actionCost(action));
+        break;
+      case SIDEHOP_LEFT_SIDEROLL_UNTARGET:
+      case SIDEHOP_RIGHT_SIDEROLL_UNTARGET:
+      case BACKFLIP_SIDEROLL_UNTARGET:
+        moveTurnCost = std::min(moveTurnCost, actionCost(action));
+        break;
+      default:
+        break;
+    }
+  }
+
+  return std::min(moveCost + turnCost, std::max(moveCost, moveTurnCost));
+}
@@ -1,11 +1,24 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
 #include <ctime>
+#include <deque>
 #include <limits>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <sys/types.h>
+#include <thread>
 
+#include "camera_cache.hpp"
 #include "global.hpp"
 #include "pos_angle_setup.hpp"
+#include "progress.hpp"
+#include "result_sink.hpp"
+#include "transposition_table.hpp"
 
 // To search an angle range spanning 0, use e.g. -0x2000 to 0x2000.
 struct PosAngleRange {
@@ -18,67 +31,169 @@ struct PosAngleRange {
   f32 zMin = 0.0f;
   f32 zMax = 0.0f;
   f32 zStep = 0.1f;
+  // Number of threads, or 0 to use all hardware threads. When running with
+  // more than one thread, the search function may be called concurrently and
+  // must be thread-safe.
+  int numThreads = 1;
+  // JSON file to write progress to every second, or empty to disable.
+  std::string statusFile;
+};
+
+// The points of a PosAngleRange. Coordinates are computed once by stepping
+// through the range (x += xStep) like a nested loop would, so points can be
+// looked up by index and all threads agree on the exact float values.
+struct PosAngleGrid {
+  std::vector<int> angles;
+  std::vector<f32> xs;
+  std::vector<f32> zs;
+
+  PosAngleGrid(const PosAngleRange& range);
+
+  unsigned long long size() const {
+    return (unsigned long long)angles.size() * xs.size() * zs.size();
+  }
+};
+
+// Up to SIZE points with the same angle, for batched range searches. Points
+// are in grid order (z varying fastest), so a batch may span several x values.
+struct PosBatch {
+  static const int SIZE = 16;
+  int count;
+  f32 x[SIZE];
+  f32 z[SIZE];
 };
 
 // Search a 2d position and angle space while printing status information to
 // stderr. The function `f` should have the signature `bool f(u16 angle, f32 x,
 // f32 z)`. It will be called for each point in the search space, and it should
 // return true if the search found an interesting result (used for status
-// printing only).
+// printing only). With one thread, points are visited in loop order (angle,
+// then x, then z).
 template <typename F>
-void searchPosAngleRange(PosAngleRange range, F f) {
-  unsigned long long tested = 0;
-  unsigned long long found = 0;
-  int angleMinFound = std::numeric_limits<int>::max();
-  int angleMaxFound = std::numeric_limits<int>::lowest();
-  f32 xMinFound = std::numeric_limits<f32>::max();
-  f32 xMaxFound = std::numeric_limits<f32>::lowest();
-  f32 zMinFound = std::numeric_limits<f32>::max();
-  f32 zMaxFound = std::numeric_limits<f32>::lowest();
-  time_t lastPrint = time(nullptr);
-
-  for (int angle = range.angleMin; angle <= range.angleMax;
-       angle += range.angleStep) {
-    for (f32 x = range.xMin; x <= range.xMax; x += range.xStep) {
-      for (f32 z = range.zMin; z <= range.zMax; z += range.zStep) {
-        time_t now = time(nullptr);
-        if (now - lastPrint >= 1) {
-          lastPrint = now;
-          fprintf(stderr, "tested:%llu found:%llu angle:%04x x:%9.3f z:%9.3f",
-                  tested, found, (u16)angle, x, z);
-          if (found > 0) {
-            fprintf(stderr,
-                    " amin:%04x amax:%04x xmin:%9.3f"
-                    " xmax:%9.3f zmin:%9.3f zmax:%9.3f",
-                    (u16)angleMinFound, (u16)angleMaxFound, xMinFound,
-                    xMaxFound, zMinFound, zMaxFound);
-          }
-          fprintf(stderr, " ...\r");
-        }
+void searchPosAngleRange(PosAngleRange range, F f);
 
-        tested++;
-        if (f(angle, x, z)) {
-          found++;
-          angleMinFound = std::min(angleMinFound, angle);
-          angleMaxFound = std::max(angleMaxFound, angle);
-          xMinFound = std::min(xMinFound, x);
-          xMaxFound = std::max(xMaxFound, x);
-          zMinFound = std::min(zMinFound, z);
-          zMaxFound = std::max(zMaxFound, z);
-        }
+// Like above, but `f` is called with batches of points so it can test them
+// together (e.g. with vector instructions). It should have the signature
+// `u32 f(u16 angle, const PosBatch& batch)` and return a mask with bit i set
+// if point i was an interesting result.
+template <typename F>
+void searchPosAngleRangeBatched(PosAngleRange range, F f);
+
+// Implementation details for range searches
+
+// Prints the final statistics of a range search.
+void printPosAngleRangeStats(ProgressReporter* reporter);
+
+// Splits the grid into chunks of points with the same angle and calls
+// chunk(progress, angle, begin, end) for each one from range.numThreads
+// threads, where begin and end are indices into the x/z points of the grid.
+template <typename F>
+void runPosAngleRange(const PosAngleRange& range, const PosAngleGrid& grid,
+                      ProgressReporter* reporter, F chunk) {
+  // A multiple of PosBatch::SIZE, so that only the last batch of each angle
+  // can be partial
+  const unsigned long long chunkSize = 4096;
+  unsigned long long numXZ =
+      (unsigned long long)grid.xs.size() * grid.zs.size();
+  unsigned long long chunksPerAngle = (numXZ + chunkSize - 1) / chunkSize;
+  unsigned long long numChunks = grid.angles.size() * chunksPerAngle;
+  std::atomic<unsigned long long> nextChunk = 0;
+
+  auto worker = [&] {
+    ProgressCounters* progress = reporter->addCounters();
+    while (true) {
+      unsigned long long i =
+          nextChunk.fetch_add(1, std::memory_order_relaxed);
+      if (i >= numChunks) {
+        break;
       }
+      unsigned long long begin = (i % chunksPerAngle) * chunkSize;
+      chunk(progress, grid.angles[i / chunksPerAngle], begin,
+            std::min(begin + chunkSize, numXZ));
     }
-  }
+  };
 
-  fprintf(stderr, "tested:%llu found:%llu", tested, found);
-  if (found > 0) {
-    fprintf(stderr,
-            " amin:%04x amax:%04x xmin:%9.3f"
-            " xmax:%9.3f zmin:%9.3f zmax:%9.3f",
-            (u16)angleMinFound, (u16)angleMaxFound, xMinFound, xMaxFound,
-            zMinFound, zMaxFound);
+  int numThreads = range.numThreads > 0
+                       ? range.numThreads
+                       : std::max(1u, std::thread::hardware_concurrency());
+  if (numThreads == 1) {
+    worker();
+    return;
   }
-  fprintf(stderr, "\n");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; i++) {
+    threads.emplace_back(worker);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+template <typename F>
+void searchPosAngleRange(PosAngleRange range, F f) {
+  PosAngleGrid grid(range);
+  ProgressReporter reporter(grid.size(), range.statusFile);
+
+  runPosAngleRange(range, grid, &reporter,
+                   [&](ProgressCounters* progress, int angle,
+                       unsigned long long begin, unsigned long long end) {
+                     int numZ = grid.zs.size();
+                     int xi = begin / numZ;
+                     int zi = begin % numZ;
+                     for (unsigned long long i = begin; i < end; i++) {
+                       f32 x = grid.xs[xi];
+                       f32 z = grid.zs[zi];
+                       progress->addTested();
+                       if (f(angle, x, z)) {
+                         progress->addFound(angle, x, z);
+                       }
+                       if (++zi == numZ) {
+                         zi = 0;
+                         xi++;
+                       }
+                     }
+                   });
+
+  reporter.stop();
+  printPosAngleRangeStats(&reporter);
+}
+
+template <typename F>
+void searchPosAngleRangeBatched(PosAngleRange range, F f) {
+  PosAngleGrid grid(range);
+  ProgressReporter reporter(grid.size(), range.statusFile);
+
+  runPosAngleRange(
+      range, grid, &reporter,
+      [&](ProgressCounters* progress, int angle, unsigned long long begin,
+          unsigned long long end) {
+        int numZ = grid.zs.size();
+        int xi = begin / numZ;
+        int zi = begin % numZ;
+        PosBatch batch;
+        for (unsigned long long i = begin; i < end; i += batch.count) {
+          batch.count = std::min<unsigned long long>(PosBatch::SIZE, end - i);
+          for (int j = 0; j < batch.count; j++) {
+            batch.x[j] = grid.xs[xi];
+            batch.z[j] = grid.zs[zi];
+            if (++zi == numZ) {
+              zi = 0;
+              xi++;
+            }
+          }
+
+          u32 found = f(angle, batch);
+          progress->addTested(batch.count);
+          for (int j = 0; j < batch.count; j++) {
+            if (found & (1u << j)) {
+              progress->addFound(angle, batch.x[j], batch.z[j]);
+            }
+          }
+        }
+      });
+
+  reporter.stop();
+  printPosAngleRangeStats(&reporter);
 }
 
 struct SearchParams {
@@ -104,6 +219,37 @@ struct SearchParams {
   f32 zMax = 10000.0f;
   // Possible actions to choose from.
   std::vector<Action> actions;
+  // Number of search threads, or 0 to use all hardware threads. When running
+  // with more than one thread, the filter and output functions may be called
+  // concurrently and must be thread-safe.
+  int numThreads = 1;
+  // Memory limit in MiB for the table of states already reached, which is used
+  // to prune paths reaching the same state at the same or higher cost. Use 0 to
+  // disable. The table is allocated once per process and cleared for each
+  // search, shard and cost band, so searches in the same process must not run
+  // at the same time.
+  int transpositionTableMB = 256;
+  // Memory limit in MiB for the cache of settled cameras, which is shared by
+  // all nodes of the search. Use 0 to disable. Allocated once per process like
+  // the table of reached states.
+  int cameraCacheMB = 32;
+  // Maximum number of unexpanded nodes kept by best-first search. Beyond this,
+  // the remaining search continues as DFS in cost bands.
+  int maxFrontier = 1000000;
+  // File to save search progress to every checkpointInterval seconds, or empty
+  // to disable. Only single-threaded DFS searches can be checkpointed; other
+  // searches fail to start if this is set.
+  std::string checkpointFile;
+  int checkpointInterval = 10;
+  // Continue from the checkpoint file if it exists. Pending output is flushed
+  // before each checkpoint, so no setup output before it is lost, but setups
+  // found between the last checkpoint and a crash are output again. Since the
+  // table of reached states starts empty, other paths to the same states may be
+  // too.
+  bool resume = false;
+  // JSON file to write progress to every second, or empty to disable. Not
+  // used by searchSetupsWorkers.
+  std::string statusFile;
 };
 
 // DFS-based setup search. Prints statistics to stderr. Output should be a
@@ -149,65 +295,210 @@ template <typename Filter, typename Output>
 void searchSetupsShard(const SearchParams& params, int depth, int shard,
                        Filter filter, Output output);
 
+// The subtree below a path of actions from one of the initial positions.
+struct SearchShard {
+  int startIndex;
+  std::vector<Action> prefix;
+  // Nodes along the prefix shallower than this belong to another shard, so
+  // they aren't counted or output.
+  int visitFrom = 0;
+};
+
+// Shard descriptors are written as "startIndex:visitFrom:ACTION,ACTION,...".
+std::string shardName(const SearchShard& shard);
+// Returns false if the name isn't a valid shard for the parameters.
+bool parseShard(const SearchParams& params, const std::string& name,
+                SearchShard* shard);
+
+// Splits the search into shards of roughly equal work, each at most about
+// 1/numShards of the total, so there are usually more than numShards of them.
+// Subtree sizes are estimated with random probes (Knuth's estimator) using the
+// same pruning as the search, so this takes a filter function like
+// searchSetups. Shards are returned largest first, and the plan only depends
+// on the parameters.
+template <typename Filter>
+std::vector<SearchShard> planShards(const SearchParams& params, int numShards,
+                                    Filter filter);
+
+std::vector<SearchShard> planShards(const SearchParams& params, int numShards);
+
+// Searches a single shard from a plan and returns its statistics.
+template <typename Output>
+SearchStats searchSetupsShard(const SearchParams& params,
+                              const SearchShard& shard, Output output);
+
+template <typename Filter, typename Output>
+SearchStats searchSetupsShard(const SearchParams& params,
+                              const SearchShard& shard, Filter filter,
+                              Output output);
+
+// Searches in numWorkers forked processes. The search is split with planShards
+// and the shards are handed out as workers become free. The output function
+// should print to stdout: each worker's stdout is collected and a shard's
+// output is only passed on once the shard is finished. A worker that crashes is
+// replaced and its shard retried, without its partial output.
+template <typename Output>
+void searchSetupsWorkers(const SearchParams& params, int numWorkers,
+                         Output output);
+
+template <typename Filter, typename Output>
+void searchSetupsWorkers(const SearchParams& params, int numWorkers,
+                         Filter filter, Output output);
+
+// Runs searchSetups or searchSetupsShard depending on the command line:
+//
+//   [shard] [--shard DESCRIPTOR] [--plan N] [--workers N] [--threads N]
+//   [--checkpoint FILE] [--resume] [--status FILE] [--best-first]
+//   [--max-frontier N] [--binary]
+//
+// The shard index is for the given shard depth. --plan prints the descriptors
+// from planShards, one per line, instead of searching. --workers runs the
+// whole search with searchSetupsWorkers. --best-first runs it with
+// searchSetupsBestFirst, so setups are output cheapest first and the search
+// can be stopped once enough have been found. --binary makes every ResultSink
+// write the binary format (see bin/print_results) instead of text.
+template <typename Output>
+void searchSetupsMain(int argc, char* argv[], SearchParams params, int depth,
+                      Output output);
+
+template <typename Filter, typename Output>
+void searchSetupsMain(int argc, char* argv[], SearchParams params, int depth,
+                      Filter filter, Output output);
+
+// Best-first setup search. Nodes are expanded in order of cost plus estimated
+// cost to the goal area, so the output function is called in nondecreasing
+// order of cost and the search can be stopped once enough setups are found.
+// Takes the same filter and output functions as searchSetups. If the frontier
+// grows beyond params.maxFrontier nodes, the rest of the search runs as
+// repeated DFS passes over bands of cost, with the setups in each band sorted
+// by cost before being output, so memory stays bounded. Always runs on a
+// single thread.
+template <typename Output>
+void searchSetupsBestFirst(const SearchParams& params, Output output);
+
+template <typename Filter, typename Output>
+void searchSetupsBestFirst(const SearchParams& params, Filter filter,
+                           Output output);
+
 // Implementation details below
 
+// Returns a lower bound on the cost to reach the goal area and angle range from
+// the setup using the configured actions, and whether the setup is already in
+// the goal area. The path is used for the cost of continuing an ESS turn.
+int estimateCostToGoal(const SearchParams& params, const PosAngleSetup& setup,
+                       const std::vector<Action>& path, bool* inGoal);
+
+struct SearchExecutor;
+
 struct SearchState {
-  unsigned long long tested = 0;  // Total number of nodes visited.
-  unsigned long long close = 0;   // Number of nodes that reached the goal area.
-  unsigned long long found = 0;   // Number of nodes that were successful.
-  time_t lastPrint;               // Time of last statistics print.
-  int startIndex;                 // Start index for current search.
+  // Number of nodes visited, nodes that reached the goal area and nodes that
+  // were successful.
+  ProgressCounters* progress;
+  ProgressReporter* reporter = nullptr;  // For the status text, if any.
+  int startIndex;                        // Start index for current search.
   Vec3f startPos;                 // Start position for current search.
   u16 startAngle;                 // Start angle for current search.
   std::vector<Action> path;       // Current path.
   std::vector<Action> startActions;  // Start actions for all search paths.
+  int visitFrom = 0;  // Depth of the first start action node to visit.
+  SearchExecutor* executor = nullptr;  // Thread pool for parallel searches.
+  int worker = 0;                      // Worker index in the thread pool.
+  TranspositionTable* table = nullptr;  // States already reached.
+  CameraCache* cameraCache = nullptr;   // Settled cameras.
+  std::string shard = "all";            // Shard name for checkpoints.
+  bool checkpointing = false;  // Whether to write params.checkpointFile.
+  time_t lastCheckpoint;       // Time of last checkpoint.
+  // When resuming, the nodes along resumePath apart from the last one have
+  // already been visited, and the nodes before it in DFS order are skipped.
+  bool resuming = false;
+  std::vector<Action> resumePath;
+};
+
+// A search subtree that hasn't been explored yet.
+struct SearchTask {
+  int startIndex;
+  int cost;
+  std::vector<Action> path;
+  PosAngleSetup setup;
 };
 
+// Work-stealing thread pool for parallel searches. Each worker owns a deque of
+// tasks: it pushes and pops subtrees at the back, and idle workers steal from
+// the front where the shallowest (and usually largest) subtrees are. Busy
+// workers split off subtrees only while some worker is idle.
+struct SearchExecutor {
+  struct Queue {
+    std::mutex mutex;
+    std::deque<SearchTask> tasks;
+  };
+
+  int numThreads;
+  std::deque<Queue> queues;
+  std::atomic<int> idle = 0;
+  // Number of tasks pushed but not yet finished.
+  std::atomic<long long> pending = 0;
+  std::mutex idleMutex;
+  std::condition_variable idleCond;
+
+  SearchExecutor(int numThreads);
+
+  // Returns true if some worker is waiting for work.
+  bool hungry() { return idle.load(std::memory_order_relaxed) > 0; }
+
+  void push(int worker, SearchTask task);
+  // Blocks until a task is available. Returns nullopt when all tasks have
+  // finished.
+  std::optional<SearchTask> pop(int worker);
+  // Marks a popped task as finished.
+  void finish();
+};
+
+// Returns the number of threads to use for the given parameters.
+int searchThreads(const SearchParams& params);
+
+// Returns the process's transposition table, empty, or nullptr if it's
+// disabled. It's only allocated again if the size in the parameters changes.
+TranspositionTable* searchTranspositionTable(const SearchParams& params);
+
+// Returns the process's camera cache, empty, or nullptr if it's disabled. It's
+// only allocated again if the size in the parameters changes.
+CameraCache* searchCameraCache(const SearchParams& params);
+
+// Saves the position of the current node, which hasn't been visited yet, and
+// the counters to params.checkpointFile. finished is set once the whole search
+// is done. Output of earlier nodes is flushed first, so the file never claims
+// more than has been written.
+void writeCheckpoint(const SearchParams& params, const SearchState& state,
+                     bool finished = false);
+// Sets up checkpointing for a single-threaded search, restoring the state from
+// params.checkpointFile when resuming. Returns false and prints an error if
+// there's nothing left to search, the checkpoint can't be used, or the search
+// runs on more than one thread.
+bool initCheckpoint(const SearchParams& params, SearchState* state);
+
 template <typename Filter, typename Output>
 void doSearch(const SearchParams& params, SearchState* state,
               const PosAngleSetup& setup, int cost, Filter filter,
               Output output) {
-  time_t now = time(nullptr);
-  if (now - state->lastPrint >= 1) {
-    state->lastPrint = now;
-    fprintf(stderr,
-            "tested=%llu close=%llu found=%llu start=%d actions=%s ...\n",
-            state->tested, state->close, state->found, state->startIndex,
-            actionNames(state->path).c_str());
+  if (state->progress->ticked()) {
+    if (state->reporter) {
+      state->reporter->setStatus("start=" + std::to_string(state->startIndex) +
+                                 " actions=" + actionNames(state->path));
+    }
+
+    time_t now = time(nullptr);
+    if (state->checkpointing &&
+        now - state->lastCheckpoint >= params.checkpointInterval) {
+      state->lastCheckpoint = now;
+      writeCheckpoint(params, *state);
+    }
   }
 
   Vec3f pos = setup.pos;
   u16 angle = setup.angle;
 
-  bool inAngleRange;
-  if (params.angleMin <= params.angleMax) {
-    inAngleRange = params.angleMin <= angle && angle <= params.angleMax;
-  } else {
-    inAngleRange = params.angleMin <= angle || angle <= params.angleMax;
-  }
-
-  f32 xDist;
-  if (pos.x < params.xMin) {
-    xDist = params.xMin - pos.x;
-  } else if (pos.x > params.xMax) {
-    xDist = pos.x - params.xMax;
-  } else {
-    xDist = 0.0f;
-  }
-
-  f32 zDist;
-  if (pos.z < params.zMin) {
-    zDist = params.zMin - pos.z;
-  } else if (pos.z > params.zMax) {
-    zDist = pos.z - params.zMax;
-  } else {
-    zDist = 0.0f;
-  }
-
-  // Estimate minimum cost to reach goal area. A sidehop moves 12.75 units per
-  // frame.
-  // TODO: estimate based on angle too?
-  int minCostToGoal = ceilf(sqrtf(SQ(xDist) + SQ(zDist)) / 12.75f);
+  bool inGoal;
+  int minCostToGoal = estimateCostToGoal(params, setup, state->path, &inGoal);
   if (cost + minCostToGoal > params.maxCost) {
     return;
   }
@@ -216,20 +507,40 @@ void doSearch(const SearchParams& params, SearchState* state,
     return;
   }
 
-  state->tested++;
-  if (inAngleRange && xDist == 0.0f && zDist == 0.0f) {
-    state->close++;
-    if (output(state->startPos, state->startAngle, setup, state->path, cost)) {
-      state->found++;
+  int k = state->path.size();
+  // Paths inside the shard prefix have restricted actions, so they can't be
+  // compared with other paths.
+  if (state->table && k >= state->startActions.size() &&
+      !state->table->visit(SearchKey(setup, state->path), cost)) {
+    return;
+  }
+
+  bool resumingAncestor = state->resuming && k < state->resumePath.size();
+  if (k >= state->visitFrom && !resumingAncestor) {
+    state->progress->addTested();
+    if (inGoal) {
+      state->progress->addClose();
+      if (output(state->startPos, state->startAngle, setup, state->path,
+                 cost)) {
+        state->progress->addFound();
+      }
     }
   }
 
-  int k = state->path.size();
   for (Action action : params.actions) {
     if (k < state->startActions.size() && action != state->startActions[k]) {
       continue;
     }
 
+    if (resumingAncestor) {
+      if (action != state->resumePath[k]) {
+        continue;
+      }
+      resumingAncestor = false;
+    } else {
+      state->resuming = false;
+    }
+
     // TODO: generalize this and record entire position/angle history?
     if (k > 0 && ((action == ROTATE_ESS_LEFT &&
                    state->path.back() == ROTATE_ESS_RIGHT) ||
@@ -254,32 +565,127 @@ void doSearch(const SearchParams& params, SearchState* state,
     }
 
     state->path.push_back(action);
-    doSearch(params, state, newSetup, newCost, filter, output);
+    if (state->executor && state->executor->hungry()) {
+      state->executor->push(state->worker, {state->startIndex, newCost,
+                                            state->path, std::move(newSetup)});
+    } else {
+      doSearch(params, state, newSetup, newCost, filter, output);
+    }
     state->path.pop_back();
   }
 }
 
+template <typename Filter, typename Output>
+void runSearchWorker(const SearchParams& params, SearchExecutor* executor,
+                     int worker, const std::vector<Action>& startActions,
+                     int visitFrom, TranspositionTable* table,
+                     ProgressReporter* reporter, Filter filter,
+                     Output output) {
+  SearchState state;
+  state.progress = reporter->addCounters();
+  state.reporter = reporter;
+  state.path.reserve(params.maxCost);
+  state.startActions = startActions;
+  state.visitFrom = visitFrom;
+  state.executor = executor;
+  state.worker = worker;
+  state.table = table;
+
+  while (std::optional<SearchTask> task = executor->pop(worker)) {
+    state.startIndex = task->startIndex;
+    state.startPos = params.starts[task->startIndex].first;
+    state.startAngle = params.starts[task->startIndex].second;
+    state.path = task->path;
+    doSearch(params, &state, task->setup, task->cost, filter, output);
+    executor->finish();
+  }
+}
+
+// Searches from each of the given start indices in parallel, sharing the
+// table, start actions and reporter from `totals`. Each worker thread adds its
+// own counters to the reporter.
+template <typename Filter, typename Output>
+void runParallelSearch(const SearchParams& params,
+                       const std::vector<int>& startIndices, Filter filter,
+                       Output output, SearchState* totals) {
+  SearchExecutor executor(searchThreads(params));
+
+  for (int i = 0; i < startIndices.size(); i++) {
+    int startIndex = startIndices[i];
+    PosAngleSetup setup(params.col, params.starts[startIndex].first,
+                        params.starts[startIndex].second, params.minBounds,
+                        params.maxBounds);
+    setup.cameraCache = totals->cameraCache;
+    for (const Collider& c : params.colliders) {
+      setup.addCollider(c);
+    }
+    executor.push(i % executor.numThreads, {startIndex, 0, {}, setup});
+  }
+
+  std::vector<std::thread> threads;
+  for (int worker = 0; worker < executor.numThreads; worker++) {
+    threads.emplace_back([&, worker] {
+      runSearchWorker(params, &executor, worker, totals->startActions,
+                      totals->visitFrom, totals->table, totals->reporter,
+                      filter, output);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
 template <typename Filter, typename Output>
 void searchSetups(const SearchParams& params, Filter filter, Output output) {
+  TranspositionTable* table = searchTranspositionTable(params);
+  CameraCache* cameraCache = searchCameraCache(params);
+  ProgressReporter reporter(0, params.statusFile);
   SearchState state;
-  state.lastPrint = time(nullptr);
+  state.progress = reporter.addCounters();
+  state.reporter = &reporter;
   state.path.reserve(params.maxCost);
+  state.table = table;
+  state.cameraCache = cameraCache;
+  if (!initCheckpoint(params, &state)) {
+    return;
+  }
 
-  for (int i = 0; i < params.starts.size(); i++) {
+  if (searchThreads(params) > 1) {
+    std::vector<int> startIndices;
+    for (int i = 0; i < params.starts.size(); i++) {
+      startIndices.push_back(i);
+    }
+    runParallelSearch(params, startIndices, filter, output, &state);
+    reporter.stop();
+    SearchStats stats = reporter.stats();
+    fprintf(stderr, "tested=%llu close=%llu found=%llu\n", stats.tested,
+            stats.close, stats.found);
+    return;
+  }
+
+  int firstStart = state.resuming ? state.startIndex : 0;
+  for (int i = firstStart; i < params.starts.size(); i++) {
     state.startIndex = i;
     state.startPos = params.starts[i].first;
     state.startAngle = params.starts[i].second;
 
     PosAngleSetup setup(params.col, state.startPos, state.startAngle,
                         params.minBounds, params.maxBounds);
+    setup.cameraCache = state.cameraCache;
     for (const Collider& c : params.colliders) {
       setup.addCollider(c);
     }
     doSearch(params, &state, setup, 0, filter, output);
+    state.resuming = false;
   }
+  if (state.checkpointing) {
+    writeCheckpoint(params, state, true);
+  }
+  reporter.stop();
 
-  fprintf(stderr, "tested=%llu close=%llu found=%llu\n", state.tested,
-          state.close, state.found);
+  SearchStats stats = reporter.stats();
+  fprintf(stderr, "tested=%llu close=%llu found=%llu\n", stats.tested,
+          stats.close, stats.found);
 }
 
 template <typename Output>
@@ -300,17 +706,14 @@ inline int numShards(const SearchParams& params, int depth) {
 template <typename Filter, typename Output>
 void searchSetupsShard(const SearchParams& params, int depth, int shard,
                        Filter filter, Output output) {
-  SearchState state;
-  state.lastPrint = time(nullptr);
-  state.path.reserve(params.maxCost);
-
+  SearchShard searchShard;
   int n = shard;
   int numActions = params.actions.size();
   for (int i = 0; i < depth; i++) {
-    state.startActions.push_back(params.actions[n % numActions]);
+    searchShard.prefix.push_back(params.actions[n % numActions]);
     n /= numActions;
   }
-  std::reverse(state.startActions.begin(), state.startActions.end());
+  std::reverse(searchShard.prefix.begin(), searchShard.prefix.end());
 
   if (n >= params.starts.size()) {
     fprintf(stderr, "shard %d must be less than %d\n", shard,
@@ -318,26 +721,646 @@ void searchSetupsShard(const SearchParams& params, int depth, int shard,
     return;
   }
 
-  int startIndex = n;
+  searchShard.startIndex = n;
+  searchSetupsShard(params, searchShard, filter, output);
+}
+
+template <typename Output>
+void searchSetupsShard(const SearchParams& params, int depth, int shard,
+                       Output output) {
+  auto filter = [](Vec3f, u16, const PosAngleSetup&, const std::vector<Action>&,
+                   int) { return true; };
+  searchSetupsShard(params, depth, shard, filter, output);
+}
+
+template <typename Filter, typename Output>
+SearchStats searchSetupsShard(const SearchParams& params,
+                              const SearchShard& shard, Filter filter,
+                              Output output) {
+  TranspositionTable* table = searchTranspositionTable(params);
+  CameraCache* cameraCache = searchCameraCache(params);
+  ProgressReporter reporter(0, params.statusFile);
+  SearchState state;
+  state.progress = reporter.addCounters();
+  state.reporter = &reporter;
+  state.path.reserve(params.maxCost);
+  state.table = table;
+  state.cameraCache = cameraCache;
+  state.startActions = shard.prefix;
+  state.visitFrom = shard.visitFrom;
+  state.shard = shardName(shard);
+
+  int startIndex = shard.startIndex;
   state.startIndex = startIndex;
+  if (!initCheckpoint(params, &state)) {
+    return {};
+  }
+
+  if (searchThreads(params) > 1) {
+    runParallelSearch(params, {startIndex}, filter, output, &state);
+    reporter.stop();
+    SearchStats stats = reporter.stats();
+    fprintf(stderr, "tested=%llu close=%llu found=%llu shard=%s\n",
+            stats.tested, stats.close, stats.found, state.shard.c_str());
+    return stats;
+  }
+
   state.startPos = params.starts[startIndex].first;
   state.startAngle = params.starts[startIndex].second;
 
   PosAngleSetup setup(params.col, state.startPos, state.startAngle,
                       params.minBounds, params.maxBounds);
+  setup.cameraCache = state.cameraCache;
   for (const Collider& c : params.colliders) {
     setup.addCollider(c);
   }
   doSearch(params, &state, setup, 0, filter, output);
+  if (state.checkpointing) {
+    writeCheckpoint(params, state, true);
+  }
+  reporter.stop();
 
-  fprintf(stderr, "tested=%llu close=%llu found=%llu shard=%d\n", state.tested,
-          state.close, state.found, shard);
+  SearchStats stats = reporter.stats();
+  fprintf(stderr, "tested=%llu close=%llu found=%llu shard=%s\n", stats.tested,
+          stats.close, stats.found, state.shard.c_str());
+  return stats;
 }
 
 template <typename Output>
-void searchSetupsShard(const SearchParams& params, int depth, int shard,
-                       Output output) {
+SearchStats searchSetupsShard(const SearchParams& params,
+                              const SearchShard& shard, Output output) {
   auto filter = [](Vec3f, u16, const PosAngleSetup&, const std::vector<Action>&,
                    int) { return true; };
-  searchSetupsShard(params, depth, shard, filter, output);
+  return searchSetupsShard(params, shard, filter, output);
+}
+
+// Hands out shards to forked worker processes and merges their output. Worker
+// stdout goes through a pipe, with a NUL byte and a "done" line with the
+// statistics after each shard.
+struct SearchCoordinator {
+  static const int MAX_ATTEMPTS = 3;
+
+  struct Task {
+    SearchShard shard;
+    int attempts = 0;
+  };
+
+  struct Worker {
+    pid_t pid;
+    int shardFd;   // Shard descriptors to the worker, or -1 when closed.
+    int outputFd;  // Worker stdout.
+    bool busy = false;
+    Task task;
+    std::string buffer;  // Output of the current shard so far.
+  };
+
+  const SearchParams* params;
+  int numWorkers;
+  std::deque<Task> queue;
+  std::vector<Worker> workers;
+  SearchStats totals;
+  int numFinished = 0;
+  int numFailed = 0;
+  // Shard descriptors from the coordinator, in a worker process.
+  FILE* shardInput = nullptr;
+
+  SearchCoordinator(const SearchParams* params,
+                    const std::vector<SearchShard>& shards, int numWorkers);
+
+  // Runs until all shards are done, and returns false. In a worker process,
+  // returns true instead; the worker should then search each shard from
+  // nextShard, report it with finishShard and finally call exitWorker.
+  bool run();
+
+  bool nextShard(SearchShard* shard);
+  void finishShard(const SearchStats& stats);
+  [[noreturn]] void exitWorker();
+
+  bool startWorker();
+  void assignShard(Worker* worker);
+  void readOutput(Worker* worker);
+  void workerExited(int index);
+};
+
+template <typename Filter, typename Output>
+void searchSetupsWorkers(const SearchParams& params, int numWorkers,
+                         Filter filter, Output output) {
+  // More shards than workers so that faster workers can pick up the slack
+  std::vector<SearchShard> shards = planShards(params, 4 * numWorkers, filter);
+  SearchCoordinator coordinator(&params, shards, numWorkers);
+  if (coordinator.run()) {
+    // Workers would all write the same status file
+    SearchParams workerParams = params;
+    workerParams.statusFile.clear();
+    SearchShard shard;
+    while (coordinator.nextShard(&shard)) {
+      coordinator.finishShard(
+          searchSetupsShard(workerParams, shard, filter, output));
+    }
+    coordinator.exitWorker();
+  }
+}
+
+template <typename Output>
+void searchSetupsWorkers(const SearchParams& params, int numWorkers,
+                         Output output) {
+  auto filter = [](Vec3f, u16, const PosAngleSetup&, const std::vector<Action>&,
+                   int) { return true; };
+  searchSetupsWorkers(params, numWorkers, filter, output);
+}
+
+// Calls f(action, setup, cost) for each child of a search node that doSearch
+// would visit, apart from transposition table pruning.
+template <typename Filter, typename F>
+void forEachSearchChild(const SearchParams& params, int startIndex,
+                        const PosAngleSetup& setup, int cost,
+                        std::vector<Action>* path, Filter filter, F f) {
+  for (Action action : params.actions) {
+    if (!path->empty() &&
+        ((action == ROTATE_ESS_LEFT && path->back() == ROTATE_ESS_RIGHT) ||
+         (action == ROTATE_ESS_RIGHT && path->back() == ROTATE_ESS_LEFT))) {
+      continue;
+    }
+
+    int newCost = cost + (!path->empty() ? actionCost(path->back(), action)
+                                         : actionCost(action));
+    if (newCost > params.maxCost) {
+      continue;
+    }
+
+    PosAngleSetup newSetup(setup);
+    if (!newSetup.performAction(action)) {
+      continue;
+    }
+
+    if (newSetup.pos == setup.pos && newSetup.angle == setup.angle) {
+      continue;
+    }
+
+    path->push_back(action);
+    bool inGoal;
+    if (newCost + estimateCostToGoal(params, newSetup, *path, &inGoal) <=
+            params.maxCost &&
+        filter(params.starts[startIndex].first,
+               params.starts[startIndex].second, newSetup, *path, newCost)) {
+      f(action, newSetup, newCost);
+    }
+    path->pop_back();
+  }
+}
+
+// A shard being planned.
+struct ShardPlanNode {
+  f64 estimate;  // Estimated number of nodes in the subtree.
+  int cost;
+  SearchShard shard;
+  PosAngleSetup setup;
+};
+
+// Returns the average of Knuth's estimate of the subtree size over several
+// random walks down from the node.
+template <typename Filter>
+f64 estimateSubtreeSize(const SearchParams& params, const ShardPlanNode& node,
+                        Filter filter, std::mt19937_64* rng) {
+  const int numProbes = 32;
+
+  struct Child {
+    Action action;
+    PosAngleSetup setup;
+    int cost;
+  };
+
+  f64 total = 0.0;
+  std::vector<Child> children;
+  for (int i = 0; i < numProbes; i++) {
+    PosAngleSetup setup = node.setup;
+    int cost = node.cost;
+    std::vector<Action> path = node.shard.prefix;
+    f64 weight = 1.0;
+    f64 estimate = 1.0;
+    while (true) {
+      children.clear();
+      forEachSearchChild(params, node.shard.startIndex, setup, cost, &path,
+                         filter,
+                         [&](Action action, const PosAngleSetup& childSetup,
+                             int childCost) {
+                           children.push_back({action, childSetup, childCost});
+                         });
+      if (children.empty()) {
+        break;
+      }
+
+      weight *= children.size();
+      estimate += weight;
+      Child& child = children[(*rng)() % children.size()];
+      path.push_back(child.action);
+      setup = child.setup;
+      cost = child.cost;
+    }
+    total += estimate;
+  }
+  return total / numProbes;
+}
+
+template <typename Filter>
+std::vector<SearchShard> planShards(const SearchParams& params, int numShards,
+                                    Filter filter) {
+  // Fixed seed so that every process computes the same plan
+  std::mt19937_64 rng(0);
+  auto smaller = [](const ShardPlanNode& a, const ShardPlanNode& b) {
+    return a.estimate < b.estimate;
+  };
+
+  CameraCache* cameraCache = searchCameraCache(params);
+  std::vector<ShardPlanNode> heap;
+  f64 total = 0.0;
+  for (int i = 0; i < params.starts.size(); i++) {
+    PosAngleSetup setup(params.col, params.starts[i].first,
+                        params.starts[i].second, params.minBounds,
+                        params.maxBounds);
+    setup.cameraCache = cameraCache;
+    for (const Collider& c : params.colliders) {
+      setup.addCollider(c);
+    }
+    ShardPlanNode node = {0.0, 0, {i, {}, 0}, setup};
+    node.estimate = estimateSubtreeSize(params, node, filter, &rng);
+    total += node.estimate;
+    heap.push_back(std::move(node));
+    std::push_heap(heap.begin(), heap.end(), smaller);
+  }
+
+  // Split the largest shard into one shard per child until every shard is
+  // small enough. The first child also takes over visiting the parent nodes.
+  f64 target = total / numShards;
+  int maxShards = 16 * numShards;
+  std::vector<ShardPlanNode> leaves;
+  while (!heap.empty() && heap.front().estimate > target &&
+         heap.size() + leaves.size() < maxShards) {
+    std::pop_heap(heap.begin(), heap.end(), smaller);
+    ShardPlanNode node = std::move(heap.back());
+    heap.pop_back();
+
+    std::vector<Action> path = node.shard.prefix;
+    int numChildren = 0;
+    forEachSearchChild(
+        params, node.shard.startIndex, node.setup, node.cost, &path, filter,
+        [&](Action action, const PosAngleSetup& setup, int cost) {
+          ShardPlanNode child = {0.0, cost, node.shard, setup};
+          child.shard.prefix.push_back(action);
+          if (numChildren > 0) {
+            child.shard.visitFrom = child.shard.prefix.size();
+          }
+          child.estimate = estimateSubtreeSize(params, child, filter, &rng);
+          heap.push_back(std::move(child));
+          std::push_heap(heap.begin(), heap.end(), smaller);
+          numChildren++;
+        });
+
+    if (numChildren == 0) {
+      leaves.push_back(std::move(node));
+    }
+  }
+
+  heap.insert(heap.end(), leaves.begin(), leaves.end());
+  std::sort(heap.begin(), heap.end(),
+            [&](const ShardPlanNode& a, const ShardPlanNode& b) {
+              return smaller(b, a);
+            });
+
+  std::vector<SearchShard> shards;
+  for (const ShardPlanNode& node : heap) {
+    shards.push_back(node.shard);
+  }
+  fprintf(stderr, "planned %zu shards: estimated nodes=%.0f largest=%.0f\n",
+          shards.size(), total, heap.empty() ? 0.0 : heap.front().estimate);
+  return shards;
+}
+
+template <typename Filter, typename Output>
+void searchSetupsMain(int argc, char* argv[], SearchParams params, int depth,
+                      Filter filter, Output output) {
+  int shard = -1;
+  std::string shardDescriptor;
+  int planSize = 0;
+  int numWorkers = 0;
+  bool bestFirst = false;
+  bool threadsGiven = false;
+  bool binary = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--shard" && i + 1 < argc) {
+      shardDescriptor = argv[++i];
+    } else if (arg == "--plan" && i + 1 < argc) {
+      planSize = atoi(argv[++i]);
+    } else if (arg == "--workers" && i + 1 < argc) {
+      numWorkers = atoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      params.numThreads = atoi(argv[++i]);
+      threadsGiven = true;
+    } else if (arg == "--checkpoint" && i + 1 < argc) {
+      params.checkpointFile = argv[++i];
+    } else if (arg == "--resume") {
+      params.resume = true;
+    } else if (arg == "--status" && i + 1 < argc) {
+      params.statusFile = argv[++i];
+    } else if (arg == "--best-first") {
+      bestFirst = true;
+    } else if (arg == "--max-frontier" && i + 1 < argc) {
+      params.maxFrontier = atoi(argv[++i]);
+    } else if (arg == "--binary") {
+      binary = true;
+    } else if (arg[0] != '-') {
+      shard = atoi(argv[i]);
+    } else {
+      fprintf(stderr,
+              "usage: %s [shard] [--shard DESCRIPTOR] [--plan N] "
+              "[--workers N] [--threads N] [--checkpoint FILE] [--resume] "
+              "[--status FILE] [--best-first] [--max-frontier N] [--binary]\n",
+              argv[0]);
+      return;
+    }
+  }
+
+  if (params.resume && params.checkpointFile.empty()) {
+    fprintf(stderr, "--resume requires --checkpoint\n");
+    return;
+  }
+  if (numWorkers > 0 && !params.checkpointFile.empty()) {
+    fprintf(stderr, "--checkpoint can't be used with --workers\n");
+    return;
+  }
+  if (searchThreads(params) > 1 && !params.checkpointFile.empty()) {
+    fprintf(stderr, "--checkpoint can only be used with --threads 1\n");
+    return;
+  }
+  if (numWorkers > 0 && !params.statusFile.empty()) {
+    fprintf(stderr, "--status can't be used with --workers\n");
+    return;
+  }
+  // The coordinator reads text lines from the workers, and each worker would
+  // write its own header
+  if (binary && numWorkers > 0) {
+    fprintf(stderr, "--binary can't be used with --workers\n");
+    return;
+  }
+  if (bestFirst && (shard >= 0 || !shardDescriptor.empty() || planSize > 0 ||
+                    numWorkers > 0 || threadsGiven ||
+                    !params.checkpointFile.empty())) {
+    fprintf(stderr,
+            "--best-first always searches everything on one thread and can't "
+            "be used with shards, --plan, --workers, --threads or "
+            "--checkpoint\n");
+    return;
+  }
+
+  if (binary) {
+    setResultSinksFormat(ResultSink::BINARY);
+  }
+
+  if (bestFirst) {
+    searchSetupsBestFirst(params, filter, output);
+  } else if (planSize > 0) {
+    for (const SearchShard& s : planShards(params, planSize, filter)) {
+      printf("%s\n", shardName(s).c_str());
+    }
+  } else if (numWorkers > 0) {
+    searchSetupsWorkers(params, numWorkers, filter, output);
+  } else if (!shardDescriptor.empty()) {
+    SearchShard s;
+    if (!parseShard(params, shardDescriptor, &s)) {
+      fprintf(stderr, "invalid shard %s\n", shardDescriptor.c_str());
+      return;
+    }
+    searchSetupsShard(params, s, filter, output);
+  } else if (shard >= 0) {
+    searchSetupsShard(params, depth, shard, filter, output);
+  } else {
+    searchSetups(params, filter, output);
+  }
+}
+
+template <typename Output>
+void searchSetupsMain(int argc, char* argv[], SearchParams params, int depth,
+                      Output output) {
+  auto filter = [](Vec3f, u16, const PosAngleSetup&, const std::vector<Action>&,
+                   int) { return true; };
+  searchSetupsMain(argc, argv, params, depth, filter, output);
+}
+
+// A best-first search node that hasn't been expanded yet.
+struct SearchNode {
+  int estimate;  // Cost plus estimated cost to goal.
+  int cost;
+  int startIndex;
+  std::vector<Action> path;
+  PosAngleSetup setup;
+};
+
+// Orders the frontier heap so that the node with the lowest estimate is on top,
+// preferring deeper nodes among equal estimates.
+inline bool searchNodeAfter(const SearchNode& a, const SearchNode& b) {
+  if (a.estimate != b.estimate) {
+    return a.estimate > b.estimate;
+  }
+  return a.cost < b.cost;
+}
+
+// Searches from the given frontier nodes by DFS in bands of cost, once the
+// best-first frontier is full. Setups costing less than `minCost` have already
+// been output.
+template <typename Filter, typename Output>
+void searchBandsFromFrontier(const SearchParams& params, SearchState* totals,
+                             std::vector<SearchNode>* frontier, int minCost,
+                             Filter filter, Output output) {
+  // Width of each cost band. Each pass repeats the work of the previous ones,
+  // so wider bands are faster but buffer more setups for sorting.
+  const int bandWidth = 8;
+
+  struct BandResult {
+    int startIndex;
+    int cost;
+    std::vector<Action> path;
+    PosAngleSetup setup;
+  };
+
+  for (int bandMin = minCost; bandMin <= params.maxCost; bandMin += bandWidth) {
+    SearchParams bandParams = params;
+    bandParams.maxCost = std::min(bandMin + bandWidth - 1, params.maxCost);
+    totals->reporter->setStatus("frontier=" + std::to_string(frontier->size()) +
+                                " band=" + std::to_string(bandMin) + "-" +
+                                std::to_string(bandParams.maxCost));
+
+    // States reached in earlier passes must not prune this one, so the table
+    // is cleared for each band.
+    TranspositionTable* table = searchTranspositionTable(bandParams);
+    // Only nodes tested count towards the totals: setups below the band have
+    // already been counted and the rest are counted when they're output.
+    ProgressCounters bandProgress;
+    SearchState state;
+    state.progress = &bandProgress;
+    state.table = table;
+
+    std::vector<BandResult> results;
+    auto bandOutput = [&](Vec3f initialPos, u16 initialAngle,
+                          const PosAngleSetup& setup,
+                          const std::vector<Action>& path, int cost) {
+      if (cost >= bandMin) {
+        results.push_back({state.startIndex, cost, path, setup});
+      }
+      return false;
+    };
+
+    for (const SearchNode& node : *frontier) {
+      if (node.estimate > bandParams.maxCost) {
+        continue;
+      }
+      state.startIndex = node.startIndex;
+      state.startPos = params.starts[node.startIndex].first;
+      state.startAngle = params.starts[node.startIndex].second;
+      state.path = node.path;
+      unsigned long long tested = bandProgress.tested;
+      doSearch(bandParams, &state, node.setup, node.cost, filter, bandOutput);
+      totals->progress->addTested(bandProgress.tested - tested);
+    }
+
+    std::stable_sort(
+        results.begin(), results.end(),
+        [](const BandResult& a, const BandResult& b) { return a.cost < b.cost; });
+    for (const BandResult& result : results) {
+      totals->progress->addClose();
+      if (output(params.starts[result.startIndex].first,
+                 params.starts[result.startIndex].second, result.setup,
+                 result.path, result.cost)) {
+        totals->progress->addFound();
+      }
+    }
+  }
+}
+
+template <typename Filter, typename Output>
+void searchSetupsBestFirst(const SearchParams& params, Filter filter,
+                           Output output) {
+  TranspositionTable* table = searchTranspositionTable(params);
+  CameraCache* cameraCache = searchCameraCache(params);
+  ProgressReporter reporter(0, params.statusFile);
+  SearchState state;
+  state.progress = reporter.addCounters();
+  state.reporter = &reporter;
+  state.table = table;
+  state.cameraCache = cameraCache;
+
+  std::vector<SearchNode> frontier;
+  auto push = [&](SearchNode node) {
+    frontier.push_back(std::move(node));
+    std::push_heap(frontier.begin(), frontier.end(), searchNodeAfter);
+  };
+
+  for (int i = 0; i < params.starts.size(); i++) {
+    PosAngleSetup setup(params.col, params.starts[i].first,
+                        params.starts[i].second, params.minBounds,
+                        params.maxBounds);
+    setup.cameraCache = state.cameraCache;
+    for (const Collider& c : params.colliders) {
+      setup.addCollider(c);
+    }
+    bool inGoal;
+    int estimate = estimateCostToGoal(params, setup, {}, &inGoal);
+    if (estimate <= params.maxCost) {
+      push({estimate, 0, i, {}, setup});
+    }
+  }
+
+  while (!frontier.empty()) {
+    if (frontier.size() > params.maxFrontier) {
+      fprintf(stderr,
+              "frontier is full with %zu nodes, continuing in cost bands from "
+              "cost %d\n",
+              frontier.size(), frontier.front().estimate);
+      state.table = nullptr;
+      searchBandsFromFrontier(params, &state, &frontier,
+                              frontier.front().estimate, filter, output);
+      break;
+    }
+
+    std::pop_heap(frontier.begin(), frontier.end(), searchNodeAfter);
+    SearchNode node = std::move(frontier.back());
+    frontier.pop_back();
+
+    if (state.progress->ticked()) {
+      reporter.setStatus("frontier=" + std::to_string(frontier.size()) +
+                         " estimate=" + std::to_string(node.estimate) +
+                         " actions=" + actionNames(node.path));
+    }
+
+    Vec3f startPos = params.starts[node.startIndex].first;
+    u16 startAngle = params.starts[node.startIndex].second;
+    if (!filter(startPos, startAngle, node.setup, node.path, node.cost)) {
+      continue;
+    }
+
+    if (state.table &&
+        !state.table->visit(SearchKey(node.setup, node.path), node.cost)) {
+      continue;
+    }
+
+    state.progress->addTested();
+    bool inGoal;
+    estimateCostToGoal(params, node.setup, node.path, &inGoal);
+    if (inGoal) {
+      state.progress->addClose();
+      if (output(startPos, startAngle, node.setup, node.path, node.cost)) {
+        state.progress->addFound();
+      }
+    }
+
+    int k = node.path.size();
+    for (Action action : params.actions) {
+      if (k > 0 && ((action == ROTATE_ESS_LEFT &&
+                     node.path.back() == ROTATE_ESS_RIGHT) ||
+                    (action == ROTATE_ESS_RIGHT &&
+                     node.path.back() == ROTATE_ESS_LEFT))) {
+        continue;
+      }
+
+      int newCost = node.cost + (k > 0 ? actionCost(node.path.back(), action)
+                                       : actionCost(action));
+      if (newCost > params.maxCost) {
+        continue;
+      }
+
+      PosAngleSetup newSetup(node.setup);
+      if (!newSetup.performAction(action)) {
+        continue;
+      }
+
+      if (newSetup.pos == node.setup.pos &&
+          newSetup.angle == node.setup.angle) {
+        continue;
+      }
+
+      std::vector<Action> newPath = node.path;
+      newPath.push_back(action);
+      int estimate =
+          newCost + estimateCostToGoal(params, newSetup, newPath, &inGoal);
+      if (estimate > params.maxCost) {
+        continue;
+      }
+
+      push({estimate, newCost, node.startIndex, std::move(newPath),
+            std::move(newSetup)});
+    }
+  }
+
+  reporter.stop();
+
+  SearchStats stats = reporter.stats();
+  fprintf(stderr, "tested=%llu close=%llu found=%llu\n", stats.tested,
+          stats.close, stats.found);
+}
+
+template <typename Output>
+void searchSetupsBestFirst(const SearchParams& params, Output output) {
+  auto filter = [](Vec3f, u16, const PosAngleSetup&, const std::vector<Action>&,
+                   int) { return true; };
+  searchSetupsBestFirst(params, filter, output);
 }
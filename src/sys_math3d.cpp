@@ -68,8 +68,8 @@ s32 Math3D_PlaneVsLineSegClosestPoint(f32 planeAA, f32 planeAB, f32 planeAC,
                                       f32 planeBC, f32 planeBDist,
                                       Vec3f* linePointA, Vec3f* linePointB,
                                       Vec3f* closestPoint) {
-  static InfiniteLine planeIntersectLine;
-  static Linef planeIntersectSeg;
+  InfiniteLine planeIntersectLine;
+  Linef planeIntersectSeg;
 
   Vec3f sp34;  // unused
 
@@ -276,7 +276,7 @@ s32 Math3D_PlaneVsPlaneVsLineClosestPoint(f32 planeAA, f32 planeAB, f32 planeAC,
                                           f32 planeBB, f32 planeBC,
                                           f32 planeBDist, Vec3f* point,
                                           Vec3f* closestPoint) {
-  static InfiniteLine planeIntersect;
+  InfiniteLine planeIntersect;
 
   if (!Math3D_PlaneVsPlaneNewLine(planeAA, planeAB, planeAC, planeADist,
                                   planeBA, planeBB, planeBC, planeBDist,
@@ -592,8 +592,8 @@ void Math3D_Vec3f_Cross(Vec3f* a, Vec3f* b, Vec3f* ret) {
  * `va` outputs the normal to `normal`
  */
 void Math3D_SurfaceNorm(Vec3f* va, Vec3f* vb, Vec3f* vc, Vec3f* normal) {
-  static Vec3f abDiff;
-  static Vec3f acDiff;
+  Vec3f abDiff;
+  Vec3f acDiff;
 
   Math_Vec3f_Diff(vb, va, &abDiff);
   Math_Vec3f_Diff(vc, va, &acDiff);
@@ -734,10 +734,10 @@ s32 Math3D_PointRelativeToCubeVertices(Vec3f* point, Vec3f* min, Vec3f* max) {
  * Checks if a line segment with endpoints `a` and `b` intersect a cube
  */
 s32 Math3D_LineVsCube(Vec3f* min, Vec3f* max, Vec3f* a, Vec3f* b) {
-  static Vec3f triVtx0;
-  static Vec3f triVtx1;
-  static Vec3f triVtx2;
-  static Vec3f intersectPoint;
+  Vec3f triVtx0;
+  Vec3f triVtx1;
+  Vec3f triVtx2;
+  Vec3f intersectPoint;
 
   s32 flags[2];
 
@@ -946,10 +946,10 @@ s32 Math3D_LineVsCube(Vec3f* min, Vec3f* max, Vec3f* a, Vec3f* b) {
  * Checks if a line segment with endpoints `a` and `b` intersect a cube
  */
 s32 Math3D_LineVsCubeShort(Vec3s* min, Vec3s* max, Vec3s* a, Vec3s* b) {
-  static Vec3f minF;
-  static Vec3f maxF;
-  static Vec3f aF;
-  static Vec3f bF;
+  Vec3f minF;
+  Vec3f maxF;
+  Vec3f aF;
+  Vec3f bF;
 
   minF.x = min->x;
   minF.y = min->y;
@@ -985,7 +985,7 @@ void Math3D_RotateXZPlane(Vec3f* pointOnPlane, s16 angle, f32* a, f32* c,
  */
 void Math3D_DefPlane(Vec3f* va, Vec3f* vb, Vec3f* vc, f32* nx, f32* ny, f32* nz,
                      f32* originDist) {
-  static Vec3f normal;
+  Vec3f normal;
 
   f32 normMagnitude;
   f32 normMagInv;
@@ -1308,7 +1308,7 @@ s32 Math3D_TriChkPointParaX(Vec3f* v0, Vec3f* v1, Vec3f* v2, f32 nx, f32 y,
 s32 Math3D_TriChkLineSegParaXIntersect(Vec3f* v0, Vec3f* v1, Vec3f* v2, f32 nx,
                                        f32 ny, f32 nz, f32 originDist, f32 y,
                                        f32 z, f32* xIntersect, f32 x0, f32 x1) {
-  static Vec3f planePos;
+  Vec3f planePos;
 
   f32 pointADist;
   f32 pointBDist;
@@ -1436,7 +1436,7 @@ s32 Math3D_TriChkPointParaZ(Vec3f* v0, Vec3f* v1, Vec3f* v2, f32 nz, f32 x,
 s32 Math3D_TriChkLineSegParaZIntersect(Vec3f* v0, Vec3f* v1, Vec3f* v2, f32 nx,
                                        f32 ny, f32 nz, f32 originDist, f32 x,
                                        f32 y, f32* zIntersect, f32 z0, f32 z1) {
-  static Vec3f planePos;
+  Vec3f planePos;
 
   f32 pointADist;
   f32 pointBDist;
@@ -1588,7 +1588,7 @@ s32 Math3D_PointInSph(Sphere16* sphere, Vec3f* point) {
  */
 s32 Math3D_PointDistSqToLine2D(f32 x0, f32 y0, f32 x1, f32 y1, f32 x2, f32 y2,
                                f32* lineLenSq) {
-  static Vec3f perpendicularPoint;
+  Vec3f perpendicularPoint;
 
   f32 perpendicularRatio;
   f32 xDiff;
@@ -1619,7 +1619,7 @@ s32 Math3D_PointDistSqToLine2D(f32 x0, f32 y0, f32 x1, f32 y1, f32 x2, f32 y2,
  * the line.
  */
 s32 Math3D_LineVsSph(Sphere16* sphere, Linef* line) {
-  static Vec3f sphLinePerpendicularPoint;
+  Vec3f sphLinePerpendicularPoint;
 
   Vec3f lineDiff;
   f32 temp_f0_2;
@@ -1667,8 +1667,8 @@ s32 Math3D_LineVsSph(Sphere16* sphere, Linef* line) {
  */
 void Math3D_GetSphVsTriIntersectPoint(Sphere16* sphere, TriNorm* tri,
                                       Vec3f* intersectPoint) {
-  static Vec3f v0v1Center;
-  static Vec3f sphereCenter;
+  Vec3f v0v1Center;
+  Vec3f sphereCenter;
 
   f32 dist;
   f32 splitRatio;
@@ -1698,9 +1698,9 @@ void Math3D_GetSphVsTriIntersectPoint(Sphere16* sphere, TriNorm* tri,
  */
 s32 Math3D_TriVsSphIntersect(Sphere16* sphere, TriNorm* tri,
                              Vec3f* intersectPoint) {
-  static Linef triTestLine;
-  static Vec3f sphereCenter;
-  static Vec3f sphPlanePos;
+  Linef triTestLine;
+  Vec3f sphereCenter;
+  Vec3f sphPlanePos;
 
   f32 radius;
   f32 nx;
@@ -2004,10 +2004,10 @@ s32 Math3D_CylVsLineSeg(Cylinder16* cyl, Vec3f* linePointA, Vec3f* linePointB,
  * is placed in `intersect` Returns 1 if they are touching, 0 otherwise.
  */
 s32 Math3D_CylTriVsIntersect(Cylinder16* cyl, TriNorm* tri, Vec3f* intersect) {
-  static Sphere16 topSphere;
-  static Sphere16 bottomSphere;
-  static Vec3f cylIntersectA;
-  static Vec3f cylIntersectB;
+  Sphere16 topSphere;
+  Sphere16 bottomSphere;
+  Vec3f cylIntersectA;
+  Vec3f cylIntersectB;
 
   f32 yIntersect;
   f32 cylTop;
@@ -2177,8 +2177,8 @@ s32 Math3D_SphVsCylOverlap(Sphere16* sph, Cylinder16* cyl, f32* overlapSize) {
  */
 s32 Math3D_SphVsCylOverlapCenterDist(Sphere16* sph, Cylinder16* cyl,
                                      f32* overlapSize, f32* centerDist) {
-  static Cylinderf cylf;
-  static Spheref sphf;
+  Cylinderf cylf;
+  Spheref sphf;
 
   f32 x;
   f32 z;
@@ -2237,8 +2237,8 @@ s32 Math3D_CylVsCylOverlap(Cylinder16* ca, Cylinder16* cb, f32* overlapSize) {
  */
 s32 Math3D_CylVsCylOverlapCenterDist(Cylinder16* ca, Cylinder16* cb,
                                      f32* overlapSize, f32* centerDist) {
-  static Cylinderf caf;
-  static Cylinderf cbf;
+  Cylinderf caf;
+  Cylinderf cbf;
 
   Math_Vec3s_ToVec3f(&caf.pos, &ca->pos);
   caf.radius = ca->radius;
@@ -22,27 +22,31 @@ MtxF gMtxFClear = {
 };
 // clang-format on
 
-MtxF gMatrixStack[20];
+// Constant-initialized, so it's reached directly through the thread pointer
+// without any initialization check.
+static constinit thread_local MatrixContext sMatrixContext;
 
-MtxF* sMatrixStack = &gMatrixStack[0];    // "Matrix_stack"
-MtxF* sCurrentMatrix = &gMatrixStack[0];  // "Matrix_now"
+MatrixContext* Matrix_GetContext(void) { return &sMatrixContext; }
 
 void Matrix_Push(void) {
-  Matrix_MtxFCopy(sCurrentMatrix + 1, sCurrentMatrix);
-  sCurrentMatrix++;
+  MatrixContext* ctx = &sMatrixContext;
+  Matrix_MtxFCopy(&ctx->stack[ctx->depth + 1], &ctx->stack[ctx->depth]);
+  ctx->depth++;
 }
 
 void Matrix_Pop(void) {
-  sCurrentMatrix--;
-  ASSERT(sCurrentMatrix >= sMatrixStack, "Matrix_now >= Matrix_stack",
+  sMatrixContext.depth--;
+  ASSERT(sMatrixContext.depth >= 0, "Matrix_now >= Matrix_stack",
          "../sys_matrix.c", 176);
 }
 
-void Matrix_Get(MtxF* dest) { Matrix_MtxFCopy(dest, sCurrentMatrix); }
+void Matrix_Get(MtxF* dest) { Matrix_MtxFCopy(dest, Matrix_GetCurrent()); }
 
-void Matrix_Put(MtxF* src) { Matrix_MtxFCopy(sCurrentMatrix, src); }
+void Matrix_Put(MtxF* src) { Matrix_MtxFCopy(Matrix_GetCurrent(), src); }
 
-MtxF* Matrix_GetCurrent(void) { return sCurrentMatrix; }
+MtxF* Matrix_GetCurrent(void) {
+  return &sMatrixContext.stack[sMatrixContext.depth];
+}
 
 void Matrix_Mult(MtxF* mf, u8 mode) {
   MtxF* cmf = Matrix_GetCurrent();
@@ -50,12 +54,12 @@ void Matrix_Mult(MtxF* mf, u8 mode) {
   if (mode == MTXMODE_APPLY) {
     SkinMatrix_MtxFMtxFMult(cmf, mf, cmf);
   } else {
-    Matrix_MtxFCopy(sCurrentMatrix, mf);
+    Matrix_MtxFCopy(Matrix_GetCurrent(), mf);
   }
 }
 
 void Matrix_Translate(f32 x, f32 y, f32 z, u8 mode) {
-  MtxF* cmf = sCurrentMatrix;
+  MtxF* cmf = Matrix_GetCurrent();
   f32 tx;
   f32 ty;
 
@@ -78,7 +82,7 @@ void Matrix_Translate(f32 x, f32 y, f32 z, u8 mode) {
 }
 
 void Matrix_Scale(f32 x, f32 y, f32 z, u8 mode) {
-  MtxF* cmf = sCurrentMatrix;
+  MtxF* cmf = Matrix_GetCurrent();
 
   if (mode == MTXMODE_APPLY) {
     cmf->xx *= x;
@@ -107,7 +111,7 @@ void Matrix_RotateX(f32 x, u8 mode) {
 
   if (mode == MTXMODE_APPLY) {
     if (x != 0) {
-      cmf = sCurrentMatrix;
+      cmf = Matrix_GetCurrent();
 
       sin = sinf(x);
       cos = cosf(x);
@@ -133,7 +137,7 @@ void Matrix_RotateX(f32 x, u8 mode) {
       cmf->wz = temp2 * cos - temp1 * sin;
     }
   } else {
-    cmf = sCurrentMatrix;
+    cmf = Matrix_GetCurrent();
 
     if (x != 0) {
       sin = sinf(x);
@@ -171,7 +175,7 @@ void Matrix_RotateY(f32 y, u8 mode) {
 
   if (mode == MTXMODE_APPLY) {
     if (y != 0) {
-      cmf = sCurrentMatrix;
+      cmf = Matrix_GetCurrent();
 
       sin = sinf(y);
       cos = cosf(y);
@@ -197,7 +201,7 @@ void Matrix_RotateY(f32 y, u8 mode) {
       cmf->wz = temp1 * sin + temp2 * cos;
     }
   } else {
-    cmf = sCurrentMatrix;
+    cmf = Matrix_GetCurrent();
 
     if (y != 0) {
       sin = sinf(y);
@@ -235,7 +239,7 @@ void Matrix_RotateZ(f32 z, u8 mode) {
 
   if (mode == MTXMODE_APPLY) {
     if (z != 0) {
-      cmf = sCurrentMatrix;
+      cmf = Matrix_GetCurrent();
 
       sin = sinf(z);
       cos = cosf(z);
@@ -261,7 +265,7 @@ void Matrix_RotateZ(f32 z, u8 mode) {
       cmf->wy = temp2 * cos - temp1 * sin;
     }
   } else {
-    cmf = sCurrentMatrix;
+    cmf = Matrix_GetCurrent();
 
     if (z != 0) {
       sin = sinf(z);
@@ -298,7 +302,7 @@ void Matrix_RotateZ(f32 z, u8 mode) {
  * Matrix_RotateXYZ, changed to reflect rotation order.
  */
 void Matrix_RotateZYX(s16 x, s16 y, s16 z, u8 mode) {
-  MtxF* cmf = sCurrentMatrix;
+  MtxF* cmf = Matrix_GetCurrent();
   f32 temp1;
   f32 temp2;
   f32 sin;
@@ -389,7 +393,7 @@ void Matrix_RotateZYX(s16 x, s16 y, s16 z, u8 mode) {
  * matrix was previously.
  */
 void Matrix_TranslateRotateZYX(Vec3f* translation, Vec3s* rotation) {
-  MtxF* cmf = sCurrentMatrix;
+  MtxF* cmf = Matrix_GetCurrent();
   f32 sin = Math_SinS(rotation->z);
   f32 cos = Math_CosS(rotation->z);
   f32 temp1;
@@ -481,7 +485,7 @@ void Matrix_TranslateRotateZYX(Vec3f* translation, Vec3s* rotation) {
  */
 void Matrix_SetTranslateRotateYXZ(f32 translateX, f32 translateY,
                                   f32 translateZ, Vec3s* rot) {
-  MtxF* cmf = sCurrentMatrix;
+  MtxF* cmf = Matrix_GetCurrent();
   f32 temp1 = Math_SinS(rot->y);
   f32 temp2 = Math_CosS(rot->y);
   f32 cos;
@@ -539,7 +543,7 @@ void Matrix_SetTranslateRotateYXZ(f32 translateX, f32 translateY,
 }
 
 void Matrix_MultVec3f(Vec3f* src, Vec3f* dest) {
-  MtxF* cmf = sCurrentMatrix;
+  MtxF* cmf = Matrix_GetCurrent();
 
   dest->x = cmf->xw + (cmf->xx * src->x + cmf->xy * src->y + cmf->xz * src->z);
   dest->y = cmf->yw + (cmf->yx * src->x + cmf->yy * src->y + cmf->yz * src->z);
@@ -636,7 +640,7 @@ void Matrix_Transpose(MtxF* mf) {
  * replacing the R rotation with `mf`, hence the function name.
  */
 void Matrix_ReplaceRotation(MtxF* mf) {
-  MtxF* cmf = sCurrentMatrix;
+  MtxF* cmf = Matrix_GetCurrent();
   f32 acc;
   f32 temp;
   f32 curColNorm;
@@ -801,7 +805,7 @@ void Matrix_RotateAxis(f32 angle, Vec3f* axis, u8 mode) {
 
   if (mode == MTXMODE_APPLY) {
     if (angle != 0) {
-      cmf = sCurrentMatrix;
+      cmf = Matrix_GetCurrent();
 
       sin = sinf(angle);
       cos = cosf(angle);
@@ -843,7 +847,7 @@ void Matrix_RotateAxis(f32 angle, Vec3f* axis, u8 mode) {
                 sin * (temp1 * axis->y - temp2 * axis->x);
     }
   } else {
-    cmf = sCurrentMatrix;
+    cmf = Matrix_GetCurrent();
 
     if (angle != 0) {
       sin = sinf(angle);
@@ -3,7 +3,19 @@
 #include "global.hpp"
 
 extern MtxF gMtxFClear;
-extern MtxF* sCurrentMatrix;
+
+// The matrix stack used by the Matrix_* functions. Each thread has its own, so
+// skeletons, weapon positions and culling can be computed on several threads
+// at once.
+struct MatrixContext {
+  MtxF stack[20] = {};
+  int depth = 0;  // Index of the current matrix ("Matrix_now")
+};
+
+// Returns the calling thread's matrix stack.
+MatrixContext* Matrix_GetContext(void);
+// Returns the calling thread's current matrix.
+MtxF* Matrix_GetCurrent(void);
 
 typedef enum {
   /* 0 */ MTXMODE_NEW,   // generates a new matrix
@@ -0,0 +1,106 @@
+#include "transposition_table.hpp"
+
+static s8 lastEssDir(const std::vector<Action>& path) {
+  if (path.empty()) {
+    return 0;
+  } else if (path.back() == ROTATE_ESS_LEFT) {
+    return 1;
+  } else if (path.back() == ROTATE_ESS_RIGHT) {
+    return -1;
+  } else {
+    return 0;
+  }
+}
+
+SearchKey::SearchKey(const PosAngleSetup& setup,
+                     const std::vector<Action>& path)
+    : x(floatToInt(setup.pos.x)),
+      y(floatToInt(setup.pos.y)),
+      z(floatToInt(setup.pos.z)),
+      angle(setup.angle),
+      cameraSetting(setup.cameraSetting),
+      targeted(setup.targeted),
+      essDir(lastEssDir(path)),
+      dynaId(setup.dynaId),
+      floorPoly(setup.floorPoly),
+      wallPoly(setup.wallPoly) {}
+
+// splitmix64 finalizer
+static u64 mix(u64 h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+u64 SearchKey::hash() const {
+  u64 h = mix(((u64)this->x << 32) | this->z);
+  h = mix(h ^ (((u64)this->y << 32) | ((u64)this->angle << 16) |
+               this->cameraSetting));
+  h = mix(h ^ (((u64)this->targeted << 40) | ((u64)(u8)this->essDir << 32) |
+               (u32)this->dynaId));
+  h = mix(h ^ (u64)(uintptr_t)this->floorPoly);
+  h = mix(h ^ (u64)(uintptr_t)this->wallPoly);
+  return h;
+}
+
+TranspositionTable::TranspositionTable(size_t maxBytes) {
+  u64 numBuckets = 1;
+  while (numBuckets * 2 * sizeof(Bucket) <= maxBytes) {
+    numBuckets *= 2;
+  }
+  this->buckets.reset(new Bucket[numBuckets]);
+  this->mask = numBuckets - 1;
+}
+
+void TranspositionTable::clear() {
+  for (u64 i = 0; i <= this->mask; i++) {
+    for (Entry& entry : this->buckets[i].entries) {
+      entry.cost = -1;
+    }
+  }
+  this->hits = 0;
+  this->evictions = 0;
+}
+
+bool TranspositionTable::visit(const SearchKey& key, int cost) {
+  Bucket* bucket = &this->buckets[key.hash() & this->mask];
+  while (bucket->lock.test_and_set(std::memory_order_acquire)) {
+  }
+
+  bool result = true;
+  Entry* replace = nullptr;
+  for (Entry& entry : bucket->entries) {
+    if (entry.cost >= 0 && entry.key == key) {
+      if (entry.cost <= cost) {
+        result = false;
+      } else {
+        entry.cost = cost;
+      }
+      replace = nullptr;
+      break;
+    }
+
+    if (!replace || entry.cost < 0 ||
+        (replace->cost >= 0 && entry.cost > replace->cost)) {
+      replace = &entry;
+    }
+  }
+
+  if (replace) {
+    if (replace->cost >= 0) {
+      this->evictions++;
+    }
+    replace->key = key;
+    replace->cost = cost;
+  }
+
+  bucket->lock.clear(std::memory_order_release);
+
+  if (!result) {
+    this->hits++;
+  }
+  return result;
+}
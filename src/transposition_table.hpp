@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "global.hpp"
+#include "pos_angle_setup.hpp"
+
+// Everything that determines which setups can be reached from a search node.
+// Camera and wall targeting data are derived from these, and the last ESS
+// direction matters because repeated ESS turns are cheaper and reversals are
+// pruned.
+struct SearchKey {
+  u32 x;
+  u32 y;
+  u32 z;
+  u16 angle;
+  u16 cameraSetting;
+  bool targeted;
+  s8 essDir;
+  int dynaId;
+  CollisionPoly* floorPoly;
+  CollisionPoly* wallPoly;
+
+  SearchKey() = default;
+  // The path is only used for its last action.
+  SearchKey(const PosAngleSetup& setup, const std::vector<Action>& path);
+
+  bool operator==(const SearchKey& rhs) const = default;
+
+  u64 hash() const;
+};
+
+// Fixed-size hash table of the lowest cost at which each search state has been
+// reached. Safe to share between search threads. When a bucket is full, the
+// entry with the highest cost is evicted since it has the smallest subtree.
+struct TranspositionTable {
+  static const int BUCKET_SIZE = 4;
+
+  struct Entry {
+    SearchKey key;
+    int cost = -1;  // -1 if empty
+  };
+
+  struct Bucket {
+    std::atomic_flag lock;
+    Entry entries[BUCKET_SIZE];
+  };
+
+  std::unique_ptr<Bucket[]> buckets;
+  u64 mask;
+
+  std::atomic<unsigned long long> hits = 0;
+  std::atomic<unsigned long long> evictions = 0;
+
+  // Allocates a table using at most the given amount of memory.
+  TranspositionTable(size_t maxBytes);
+
+  // Removes all entries, so the table can be reused for another search.
+  void clear();
+
+  // Records that a state was reached with the given cost. Returns false if the
+  // state was already reached with the same or lower cost, in which case the
+  // node can be pruned.
+  bool visit(const SearchKey& key, int cost);
+};